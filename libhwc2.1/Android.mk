@@ -29,7 +29,11 @@ LOCAL_SRC_FILES += \
 	../../zuma/libhwc2.1/libdisplayinterface/ExynosDisplayDrmInterfaceModule.cpp \
 	../../zuma/libhwc2.1/libcolormanager/DisplayColorModule.cpp \
 	../../zuma/libhwc2.1/libdevice/ExynosDeviceModule.cpp \
-	../../zuma/libhwc2.1/libdevice/HistogramController.cpp
+	../../zuma/libhwc2.1/libdevice/HistogramController.cpp \
+	../../zuma/libhwc2.1/libresource/TDMAssignSolver.cpp \
+	../../zuma/libhwc2.1/libresource/TDMOccupancy.cpp \
+	../../zuma/libhwc2.1/libresource/TDMPartitioner.cpp \
+	../../zuma/libhwc2.1/libresource/TDMUtilization.cpp
 
 LOCAL_CFLAGS += -DDISPLAY_COLOR_LIB=\"libdisplaycolor.so\"
 
@@ -31,12 +31,23 @@ typedef enum assignOrderType {
     ORDER_AXI,
 } assignOrderType_t;
 
+/* Placement of layers on DPP channels */
+typedef enum packingPolicy {
+    PACKING_SPREAD,     // balance AXI ports and DPUF blocks
+    PACKING_LIGHT_LOAD, // consolidate onto PACKING_BLOCK while the stack is light
+    PACKING_ALWAYS,     // consolidate onto PACKING_BLOCK, e.g. in battery saver
+    PACKING_POLICY_CNT,
+} packingPolicy_t;
+
 typedef enum DPUblockId {
     DPUF0,
     DPUF1,
     DPU_BLOCK_CNT,
 } DPUblockId_t;
 
+/* DPUF that stays powered when layers are packed, DPUF1 can be gated */
+constexpr DPUblockId_t PACKING_BLOCK = DPUF0;
+
 const std::unordered_map<DPUblockId_t, String8> DPUBlocks = {
     {DPUF0, String8("DPUF0")},
     {DPUF1, String8("DPUF1")},
@@ -140,11 +151,6 @@ static const std::array<exynos_display_t, 3> AVAILABLE_DISPLAY_UNITS = {{
     {HWC_DISPLAY_EXTERNAL, 0, "ExternalDisplay", "/dev/dri/card0", ""}
 }};
 
-/*
- * Note :
- * When External or Virtual display is connected,
- * Primary amount = total - others
- */
 class HWResourceIndexes {
     private:
         tdm_attr_t attr;
@@ -162,20 +168,6 @@ class HWResourceIndexes {
                 axiId(_axiId),
                 dispType(_dispType),
                 constraintRev(_constraintRev) {}
-        bool operator<(const HWResourceIndexes& rhs) const {
-            if (attr != rhs.attr) return attr < rhs.attr;
-
-            if (DPUBlockNo != rhs.DPUBlockNo) return DPUBlockNo < rhs.DPUBlockNo;
-
-            if (dispType != rhs.dispType) return dispType < rhs.dispType;
-
-            if (axiId != AXI_DONT_CARE && rhs.axiId != AXI_DONT_CARE && axiId != rhs.axiId)
-                return axiId < rhs.axiId;
-
-            if (constraintRev != CONSTRAINT_NONE) return constraintRev < rhs.constraintRev;
-
-            return false;
-        }
         String8 toString8() const {
             String8 log;
             log.appendFormat("attr=%d,DPUBlockNo=%d,axiId=%d,dispType=%d,constraintRev=%d", attr,
@@ -189,151 +181,312 @@ typedef struct HWResourceAmounts {
     int totalAmount;
 } HWResourceAmounts_t;
 
-/* Note :
- * When External or Virtual display is connected,
- * Primary amount = total - others */
-
-const std::map<HWResourceIndexes, HWResourceAmounts_t> HWResourceTables = {
-        {HWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {80, 80}},
-        {HWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {0, 80}},
-        {HWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {0, 80}},
-        {HWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {80, 80}},
-        {HWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {80, 80}},
-        {HWResourceIndexes(TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {80, 80}},
-
-        {HWResourceIndexes(TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-
-        {HWResourceIndexes(TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-
-        {HWResourceIndexes(TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-        {HWResourceIndexes(TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {0, 4}},
-        {HWResourceIndexes(TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {0, 4}},
-        {HWResourceIndexes(TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-        {HWResourceIndexes(TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-        {HWResourceIndexes(TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-
-        {HWResourceIndexes(TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-        {HWResourceIndexes(TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {0, 4}},
-        {HWResourceIndexes(TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {0, 4}},
-        {HWResourceIndexes(TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-        {HWResourceIndexes(TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-        {HWResourceIndexes(TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {4, 4}},
-
-        {HWResourceIndexes(TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL,
-                           CONSTRAINT_NONE),
-         {2, 2}},
-
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_A0),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_A0),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_A0),
-         {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_A0),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_A0),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_A0),
-         {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI0, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0), {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI0, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0), {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI0, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0), {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI1, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0), {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI1, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0), {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF0, AXI1, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0), {0, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI0, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0), {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI0, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0), {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI0, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0), {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI1, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0), {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI1, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0), {2, 2}},
-        {HWResourceIndexes(TDM_ATTR_WCG, DPUF1, AXI1, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0), {2, 2}},
+/*
+ * AXI_DONT_CARE and CONSTRAINT_NONE in a rule match any AXI port and any constraint revision.
+ * A rule with a specific AXI port and constraint revision overrides the matching wildcards.
+ */
+typedef struct HWResourceRule {
+    tdm_attr_t attr;
+    DPUblockId_t DPUBlockNo;
+    AXIPortId_t axiId;
+    int dispType;
+    ConstraintRev_t constraintRev;
+    HWResourceAmounts_t amounts;
+} HWResourceRule_t;
+
+/*
+ * totalAmount is the amount of the resource shared by every display type.
+ * Enabled non-primary displays get up to their maxAssignedAmount, what their layers need once
+ * they have validated, the primary display gets what they leave of totalAmount, up to its
+ * own maxAssignedAmount.
+ */
+
+inline constexpr HWResourceRule_t HWResourceRules[] = {
+        {TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {80, 80}},
+        {TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {0, 80}},
+        {TDM_ATTR_SRAM_AMOUNT, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {0, 80}},
+        {TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {80, 80}},
+        {TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {80, 80}},
+        {TDM_ATTR_SRAM_AMOUNT, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {80, 80}},
+
+        {TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {0, 2}},
+        {TDM_ATTR_SCALE, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {0, 2}},
+        {TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_SCALE, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {2, 2}},
+
+        {TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {0, 2}},
+        {TDM_ATTR_SBWC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {0, 2}},
+        {TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_SBWC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {2, 2}},
+
+        {TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {4, 4}},
+        {TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {0, 4}},
+        {TDM_ATTR_AFBC, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {0, 4}},
+        {TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {4, 4}},
+        {TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {4, 4}},
+        {TDM_ATTR_AFBC, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {4, 4}},
+
+        {TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {4, 4}},
+        {TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {0, 4}},
+        {TDM_ATTR_ITP, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {0, 4}},
+        {TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {4, 4}},
+        {TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {4, 4}},
+        {TDM_ATTR_ITP, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {4, 4}},
+
+        {TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {0, 2}},
+        {TDM_ATTR_ROT_90, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {0, 2}},
+        {TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_NONE, {2, 2}},
+        {TDM_ATTR_ROT_90, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_NONE, {2, 2}},
+
+        {TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_A0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_A0, {0, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_A0, {0, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_PRIMARY, CONSTRAINT_A0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_EXTERNAL, CONSTRAINT_A0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI_DONT_CARE, HWC_DISPLAY_VIRTUAL, CONSTRAINT_A0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI0, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI0, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0, {0, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI0, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0, {0, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI1, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI1, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0, {0, 2}},
+        {TDM_ATTR_WCG, DPUF0, AXI1, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0, {0, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI0, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI0, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI0, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI1, HWC_DISPLAY_PRIMARY, CONSTRAINT_B0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI1, HWC_DISPLAY_EXTERNAL, CONSTRAINT_B0, {2, 2}},
+        {TDM_ATTR_WCG, DPUF1, AXI1, HWC_DISPLAY_VIRTUAL, CONSTRAINT_B0, {2, 2}},
 };
 
+/*
+ * Dense budget table of every (attr, DPUF, AXI, display type, constraint revision),
+ * wildcards of HWResourceRules are expanded at compile time.
+ * AXI_DONT_CARE has its own slot after the AXI ports.
+ */
+typedef struct HWResourceBudget {
+    bool valid;
+    HWResourceAmounts_t amounts;
+} HWResourceBudget_t;
+
+constexpr uint32_t HW_RESOURCE_AXI_SLOT_CNT = AXI_PORT_MAX_CNT + 1;
+constexpr uint32_t HW_RESOURCE_CONSTRAINT_CNT = CONSTRAINT_B0 + 1;
+constexpr uint32_t HW_RESOURCE_BUDGET_CNT = TDM_ATTR_MAX * DPU_BLOCK_CNT *
+        HW_RESOURCE_AXI_SLOT_CNT * HWC_NUM_DISPLAY_TYPES * HW_RESOURCE_CONSTRAINT_CNT;
+
+using HWResourceBudgetTable = std::array<HWResourceBudget_t, HW_RESOURCE_BUDGET_CNT>;
+
+constexpr bool isValidHWResourceIndex(uint32_t attr, uint32_t blkId, uint32_t axiId,
+                                      int dispType, uint32_t constraintRev) {
+    return (attr < TDM_ATTR_MAX) && (blkId < DPU_BLOCK_CNT) &&
+            ((axiId < AXI_PORT_MAX_CNT) || (axiId == AXI_DONT_CARE)) && (dispType >= 0) &&
+            (dispType < HWC_NUM_DISPLAY_TYPES) && (constraintRev < HW_RESOURCE_CONSTRAINT_CNT);
+}
+
+constexpr uint32_t getHWResourceBudgetIndex(uint32_t attr, uint32_t blkId, uint32_t axiId,
+                                            int dispType, uint32_t constraintRev) {
+    const uint32_t axiSlot =
+            (axiId == AXI_DONT_CARE) ? static_cast<uint32_t>(AXI_PORT_MAX_CNT) : axiId;
+    return (((attr * DPU_BLOCK_CNT + blkId) * HW_RESOURCE_AXI_SLOT_CNT + axiSlot) *
+                    HWC_NUM_DISPLAY_TYPES +
+            dispType) * HW_RESOURCE_CONSTRAINT_CNT +
+            constraintRev;
+}
+
+constexpr uint32_t getHWResourceAxiId(uint32_t axiSlot) {
+    return (axiSlot == AXI_PORT_MAX_CNT) ? static_cast<uint32_t>(AXI_DONT_CARE) : axiSlot;
+}
+
+constexpr HWResourceBudgetTable makeHWResourceBudgetTable() {
+    HWResourceBudgetTable table{};
+    /* Expand wildcard rules first so that specific rules override them */
+    for (const bool wildcardPass : {true, false}) {
+        for (const auto &rule : HWResourceRules) {
+            const bool wildcard =
+                    (rule.axiId == AXI_DONT_CARE) || (rule.constraintRev == CONSTRAINT_NONE);
+            if (wildcard != wildcardPass) continue;
+            for (uint32_t axi = 0; axi < HW_RESOURCE_AXI_SLOT_CNT; axi++) {
+                const uint32_t axiId = getHWResourceAxiId(axi);
+                if ((rule.axiId != AXI_DONT_CARE) && (rule.axiId != axiId)) continue;
+                for (uint32_t rev = 0; rev < HW_RESOURCE_CONSTRAINT_CNT; rev++) {
+                    if ((rule.constraintRev != CONSTRAINT_NONE) && (rule.constraintRev != rev))
+                        continue;
+                    table[getHWResourceBudgetIndex(rule.attr, rule.DPUBlockNo, axiId,
+                                                   rule.dispType, rev)] = {true, rule.amounts};
+                }
+            }
+        }
+    }
+    /* An AXI_DONT_CARE lookup without its own rule finds the rules of the AXI ports */
+    for (const auto &rule : HWResourceRules) {
+        if (rule.axiId == AXI_DONT_CARE) continue;
+        for (uint32_t rev = 0; rev < HW_RESOURCE_CONSTRAINT_CNT; rev++) {
+            if ((rule.constraintRev != CONSTRAINT_NONE) && (rule.constraintRev != rev)) continue;
+            auto &budget = table[getHWResourceBudgetIndex(rule.attr, rule.DPUBlockNo,
+                                                          AXI_DONT_CARE, rule.dispType, rev)];
+            if (!budget.valid) budget = {true, rule.amounts};
+        }
+    }
+    return table;
+}
+
+inline constexpr HWResourceBudgetTable HWResourceTables = makeHWResourceBudgetTable();
+
+constexpr const HWResourceBudget_t *getHWResourceBudget(const HWResourceBudgetTable &table,
+                                                        uint32_t attr, uint32_t blkId,
+                                                        uint32_t axiId, int dispType,
+                                                        uint32_t constraintRev) {
+    if (!isValidHWResourceIndex(attr, blkId, axiId, dispType, constraintRev)) return nullptr;
+    const auto &budget = table[getHWResourceBudgetIndex(attr, blkId, axiId, dispType,
+                                                        constraintRev)];
+    return budget.valid ? &budget : nullptr;
+}
+
+/*
+ * Every rule should be found with every AXI port and constraint revision it matches,
+ * and rules matching the same entry should not disagree on the amounts.
+ */
+constexpr bool isHWResourceTableConsistent() {
+    for (const auto &rule : HWResourceRules) {
+        if (!isValidHWResourceIndex(rule.attr, rule.DPUBlockNo, rule.axiId, rule.dispType,
+                                    rule.constraintRev))
+            return false;
+        for (uint32_t axi = 0; axi < HW_RESOURCE_AXI_SLOT_CNT; axi++) {
+            const uint32_t axiId = getHWResourceAxiId(axi);
+            if ((rule.axiId != AXI_DONT_CARE) && (rule.axiId != axiId)) continue;
+            for (uint32_t rev = CONSTRAINT_A0; rev < HW_RESOURCE_CONSTRAINT_CNT; rev++) {
+                if ((rule.constraintRev != CONSTRAINT_NONE) && (rule.constraintRev != rev))
+                    continue;
+                const auto *budget = getHWResourceBudget(HWResourceTables, rule.attr,
+                                                         rule.DPUBlockNo, axiId, rule.dispType,
+                                                         rev);
+                if ((budget == nullptr) ||
+                    (budget->amounts.maxAssignedAmount != rule.amounts.maxAssignedAmount) ||
+                    (budget->amounts.totalAmount != rule.amounts.totalAmount))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+static_assert(isHWResourceTableConsistent(), "HWResourceRules has conflicting rules");
+
+/*
+ * Every attribute should have a budget for every DPUF and display type,
+ * either for AXI_DONT_CARE or for every AXI port.
+ */
+constexpr bool isHWResourceTableComplete() {
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        for (uint32_t blk = 0; blk < DPU_BLOCK_CNT; blk++) {
+            for (int type = 0; type < HWC_NUM_DISPLAY_TYPES; type++) {
+                for (uint32_t rev = CONSTRAINT_A0; rev < HW_RESOURCE_CONSTRAINT_CNT; rev++) {
+                    if (getHWResourceBudget(HWResourceTables, attr, blk, AXI_DONT_CARE, type,
+                                            rev))
+                        continue;
+                    for (uint32_t axi = 0; axi < AXI_PORT_MAX_CNT; axi++) {
+                        if (!getHWResourceBudget(HWResourceTables, attr, blk, axi, type, rev))
+                            return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+static_assert(isHWResourceTableComplete(), "HWResourceRules misses a budget");
+
+/* The displays of a resource split one pool, so they should agree on its totalAmount */
+constexpr bool isHWResourceTotalShared() {
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        for (uint32_t blk = 0; blk < DPU_BLOCK_CNT; blk++) {
+            for (uint32_t slot = 0; slot < HW_RESOURCE_AXI_SLOT_CNT; slot++) {
+                for (uint32_t rev = CONSTRAINT_A0; rev < HW_RESOURCE_CONSTRAINT_CNT; rev++) {
+                    int total = -1;
+                    for (int type = 0; type < HWC_NUM_DISPLAY_TYPES; type++) {
+                        const auto *budget = getHWResourceBudget(HWResourceTables, attr, blk,
+                                                                 getHWResourceAxiId(slot), type,
+                                                                 rev);
+                        if (budget == nullptr) continue;
+                        if ((total >= 0) && (budget->amounts.totalAmount != total)) return false;
+                        total = budget->amounts.totalAmount;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+static_assert(isHWResourceTotalShared(), "HWResourceRules has different totals for a resource");
+
+/*
+ * HWResourceRules are the entries of the std::map the dense table replaced, which found an
+ * entry equivalent to the key under this ordering: AXI_DONT_CARE on either side matches any
+ * AXI port and CONSTRAINT_NONE in the entry matches any constraint revision.
+ */
+constexpr bool isLegacyHWResourceLess(const HWResourceRule_t &lhs, const HWResourceRule_t &rhs) {
+    if (lhs.attr != rhs.attr) return lhs.attr < rhs.attr;
+    if (lhs.DPUBlockNo != rhs.DPUBlockNo) return lhs.DPUBlockNo < rhs.DPUBlockNo;
+    if (lhs.dispType != rhs.dispType) return lhs.dispType < rhs.dispType;
+    if (lhs.axiId != AXI_DONT_CARE && rhs.axiId != AXI_DONT_CARE && lhs.axiId != rhs.axiId)
+        return lhs.axiId < rhs.axiId;
+    if (lhs.constraintRev != CONSTRAINT_NONE) return lhs.constraintRev < rhs.constraintRev;
+    return false;
+}
+
+/*
+ * Every (attr, DPUF, AXI port or AXI_DONT_CARE, display type) lookup of both constraint
+ * revisions finds the amounts the map found, and misses where the map missed.
+ * Keys the map had several equivalent entries for should not depend on the one it found.
+ */
+constexpr bool isHWResourceTableLegacyEquivalent() {
+    for (uint32_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        for (uint32_t blk = 0; blk < DPU_BLOCK_CNT; blk++) {
+            for (uint32_t axi = 0; axi < HW_RESOURCE_AXI_SLOT_CNT; axi++) {
+                for (int type = 0; type < HWC_NUM_DISPLAY_TYPES; type++) {
+                    for (uint32_t rev = CONSTRAINT_A0; rev < HW_RESOURCE_CONSTRAINT_CNT;
+                         rev++) {
+                        const HWResourceRule_t key = {static_cast<tdm_attr_t>(attr),
+                                                      static_cast<DPUblockId_t>(blk),
+                                                      static_cast<AXIPortId_t>(
+                                                              getHWResourceAxiId(axi)),
+                                                      type,
+                                                      static_cast<ConstraintRev_t>(rev),
+                                                      {0, 0}};
+                        const HWResourceAmounts_t *found = nullptr;
+                        for (const auto &rule : HWResourceRules) {
+                            if (isLegacyHWResourceLess(key, rule) ||
+                                isLegacyHWResourceLess(rule, key))
+                                continue;
+                            if (found &&
+                                ((found->maxAssignedAmount !=
+                                  rule.amounts.maxAssignedAmount) ||
+                                 (found->totalAmount != rule.amounts.totalAmount)))
+                                return false;
+                            found = &rule.amounts;
+                        }
+
+                        const auto *budget = getHWResourceBudget(HWResourceTables, attr, blk,
+                                                                 key.axiId, type, rev);
+                        if ((found == nullptr) != (budget == nullptr)) return false;
+                        if (found &&
+                            ((budget->amounts.maxAssignedAmount != found->maxAssignedAmount) ||
+                             (budget->amounts.totalAmount != found->totalAmount)))
+                            return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+static_assert(isHWResourceTableLegacyEquivalent(),
+              "HWResourceTables lookups differ from the HWResourceRules map");
+
 typedef enum lbWidthIndex {
     LB_W_8_512,
     LB_W_513_1024,
@@ -343,6 +496,7 @@ typedef enum lbWidthIndex {
     LB_W_2305_2560,
     LB_W_2561_3072,
     LB_W_3073_INF,
+    LB_W_CNT,
 } lbWidthIndex_t;
 
 typedef struct lbWidthBoundary {
@@ -350,146 +504,91 @@ typedef struct lbWidthBoundary {
     uint32_t widthUpto;
 } lbWidthBoundary_t;
 
-const std::map<lbWidthIndex_t, lbWidthBoundary_t> LB_WIDTH_INDEX_MAP = {
-    {LB_W_8_512,     {8, 512}},
-    {LB_W_513_1024,  {513, 1024}},
-    {LB_W_1025_1536, {1025, 1536}},
-    {LB_W_1537_2048, {1537, 2048}},
-    {LB_W_2049_2304, {2049, 2304}},
-    {LB_W_2305_2560, {2035, 2560}},
-    {LB_W_2561_3072, {2561, 3072}},
-    {LB_W_3073_INF,  {3073, 0xffff}},
+inline constexpr lbWidthBoundary_t LB_WIDTH_BOUNDARIES[LB_W_CNT] = {
+    {8, 512},
+    {513, 1024},
+    {1025, 1536},
+    {1537, 2048},
+    {2049, 2304},
+    {2305, 2560},
+    {2561, 3072},
+    {3073, 0xffff},
 };
 
-class sramAmountParams {
-private:
-    tdm_attr_t attr;
-    uint32_t formatProperty;
-    lbWidthIndex_t widthIndex;
-
-public:
-    sramAmountParams(tdm_attr_t _attr, uint32_t _formatProperty, lbWidthIndex_t _widthIndex)
-          : attr(_attr), formatProperty(_formatProperty), widthIndex(_widthIndex) {}
-    bool operator<(const sramAmountParams& rhs) const {
-        if (attr != rhs.attr) return attr < rhs.attr;
-
-        if (formatProperty != rhs.formatProperty) return formatProperty < rhs.formatProperty;
-
-        if (widthIndex != rhs.widthIndex) return widthIndex < rhs.widthIndex;
-
-        return false;
+constexpr bool isLbWidthBoundaryContiguous() {
+    for (uint32_t i = 0; i < LB_W_CNT; i++) {
+        if (LB_WIDTH_BOUNDARIES[i].widthDownto > LB_WIDTH_BOUNDARIES[i].widthUpto) return false;
+        if ((i > 0) &&
+            (LB_WIDTH_BOUNDARIES[i].widthDownto != LB_WIDTH_BOUNDARIES[i - 1].widthUpto + 1))
+            return false;
     }
+    return true;
+}
+static_assert(isLbWidthBoundaryContiguous(),
+              "line buffer width bands should be contiguous and not overlapped");
+
+/* Width out of the bands is regarded as the widest one */
+constexpr lbWidthIndex_t getLbWidthIndex(int32_t w) {
+    if ((w < static_cast<int32_t>(LB_WIDTH_BOUNDARIES[0].widthDownto)) ||
+        (w > static_cast<int32_t>(LB_WIDTH_BOUNDARIES[LB_W_CNT - 1].widthUpto)))
+        return LB_W_3073_INF;
+
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < LB_W_CNT - 1; i++)
+        index += (static_cast<uint32_t>(w) > LB_WIDTH_BOUNDARIES[i].widthUpto);
+    return static_cast<lbWidthIndex_t>(index);
+}
+static_assert(getLbWidthIndex(8) == LB_W_8_512 && getLbWidthIndex(512) == LB_W_8_512);
+static_assert(getLbWidthIndex(2048) == LB_W_1537_2048 && getLbWidthIndex(2305) == LB_W_2305_2560);
+static_assert(getLbWidthIndex(3073) == LB_W_3073_INF && getLbWidthIndex(4) == LB_W_3073_INF);
+
+/* Rows of the SRAM amount table, each is a (TDM attribute, format property) */
+typedef enum sramAmountRow {
+    SRAM_ROW_NONE = 0,
+    /** Non rotation **/
+    SRAM_AFBC_RGB_32BIT,
+    SRAM_AFBC_RGB_16BIT,
+    SRAM_SBWC_Y,
+    SRAM_SBWC_UV,
+    /** Rotation **/
+    SRAM_ROT_Y_8BIT,
+    SRAM_ROT_UV_8BIT,
+    SRAM_ROT_Y_10BIT,
+    SRAM_ROT_UV_10BIT,
+    SRAM_ROT_SBWC_Y,
+    SRAM_ROT_SBWC_UV,
+    SRAM_ITP_8BIT,
+    SRAM_ITP_10BIT,
+    /* FORMAT_YUV_MASK == has no alpha, FORMAT_RGB_MASK == has alpha */
+    SRAM_SCALE_NO_ALPHA,
+    SRAM_SCALE_ALPHA,
+    SRAM_ROW_CNT,
+} sramAmountRow_t;
+
+inline constexpr uint8_t SRAM_AMOUNT_TABLE[SRAM_ROW_CNT][LB_W_CNT] = {
+    /*  8-     513-   1025-  1537-  2049-  2305-  2561-  3073- */
+    {   0,     0,     0,     0,     0,     0,     0,     0},     // SRAM_ROW_NONE
+    {   4,     4,     8,     8,     12,    12,    12,    16},    // SRAM_AFBC_RGB_32BIT
+    {   2,     2,     4,     4,     6,     6,     6,     8},     // SRAM_AFBC_RGB_16BIT
+    {   1,     1,     1,     1,     2,     2,     2,     2},     // SRAM_SBWC_Y
+    {   2,     2,     2,     2,     2,     2,     2,     2},     // SRAM_SBWC_UV
+    {   4,     8,     12,    16,    18,    18,    18,    18},    // SRAM_ROT_Y_8BIT
+    {   2,     4,     6,     8,     10,    10,    10,    10},    // SRAM_ROT_UV_8BIT
+    {   2,     4,     6,     8,     9,     9,     9,     9},     // SRAM_ROT_Y_10BIT
+    {   2,     2,     4,     4,     6,     6,     6,     6},     // SRAM_ROT_UV_10BIT
+    {   2,     4,     6,     8,     9,     9,     9,     9},     // SRAM_ROT_SBWC_Y
+    {   2,     2,     4,     4,     6,     6,     6,     6},     // SRAM_ROT_SBWC_UV
+    /* ITP and scale have no size difference, only LB_W_3073_INF is used */
+    {   0,     0,     0,     0,     0,     0,     0,     2},     // SRAM_ITP_8BIT
+    {   0,     0,     0,     0,     0,     0,     0,     2},     // SRAM_ITP_10BIT
+    {   0,     0,     0,     0,     0,     0,     0,     12},    // SRAM_SCALE_NO_ALPHA
+    {   0,     0,     0,     0,     0,     0,     0,     16},    // SRAM_SCALE_ALPHA
 };
 
-enum {
-    SBWC_Y = 0,
-    SBWC_UV,
-    NON_SBWC_Y,
-    NON_SBWC_UV,
-};
-
-const std::map<sramAmountParams, uint32_t> sramAmountMap = {
-    /** Non rotation **/
-    /** BIT8 = 32bit format **/
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_8_512),     4},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_513_1024),  4},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_1025_1536), 8},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_1537_2048), 8},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_2049_2304), 12},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_2305_2560), 12},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_2561_3072), 12},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB | BIT8, LB_W_3073_INF),  16},
-
-    /** 16bit format **/
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_8_512),     2},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_513_1024),  2},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_1025_1536), 4},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_1537_2048), 4},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_2049_2304), 6},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_2305_2560), 6},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_2561_3072), 6},
-    {sramAmountParams(TDM_ATTR_AFBC, RGB, LB_W_3073_INF),  8},
-
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_8_512),     1},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_513_1024),  1},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_1025_1536), 1},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_1537_2048), 1},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_2049_2304), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_2305_2560), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_2561_3072), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_Y, LB_W_3073_INF),  2},
-
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_8_512),     2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_513_1024),  2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_1025_1536), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_1537_2048), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_2049_2304), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_2305_2560), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_2561_3072), 2},
-    {sramAmountParams(TDM_ATTR_SBWC, SBWC_UV, LB_W_3073_INF),  2},
+constexpr uint32_t getSramAmount(sramAmountRow_t row, lbWidthIndex_t widthIndex) {
+    return SRAM_AMOUNT_TABLE[row][widthIndex];
+}
 
-    /** Rotation **/
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_8_512),     4},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_513_1024),  8},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_1025_1536), 12},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_1537_2048), 16},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_2049_2304), 18},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_2305_2560), 18},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_2561_3072), 18},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT8, LB_W_3073_INF),  18},
-
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_8_512),     2},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_513_1024),  4},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_1025_1536), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_1537_2048), 8},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_2049_2304), 10},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_2305_2560), 10},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_2561_3072), 10},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT8, LB_W_3073_INF),  10},
-
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_8_512),     2},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_513_1024),  4},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_1025_1536), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_1537_2048), 8},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_2049_2304), 9},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_2305_2560), 9},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_2561_3072), 9},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_Y | BIT10, LB_W_3073_INF),  9},
-
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_8_512),     2},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_513_1024),  2},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_1025_1536), 4},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_1537_2048), 4},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_2049_2304), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_2305_2560), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_2561_3072), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, NON_SBWC_UV | BIT10, LB_W_3073_INF),  6},
-
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_8_512),     2},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_513_1024),  4},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_1025_1536), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_1537_2048), 8},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_2049_2304), 9},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_2305_2560), 9},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_2561_3072), 9},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_Y, LB_W_3073_INF),  9},
-
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_8_512),     2},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_513_1024),  2},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_1025_1536), 4},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_1537_2048), 4},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_2049_2304), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_2305_2560), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_2561_3072), 6},
-    {sramAmountParams(TDM_ATTR_ROT_90, SBWC_UV, LB_W_3073_INF),  6},
-
-    {sramAmountParams(TDM_ATTR_ITP, BIT8, LB_W_3073_INF),  2},
-    {sramAmountParams(TDM_ATTR_ITP, BIT10, LB_W_3073_INF), 2},
-
-    /* It's meaning like ow,
-     * FORMAT_YUV_MASK == has no alpha, FORMAT_RGB_MASK == has alpha */
-    {sramAmountParams(TDM_ATTR_SCALE, FORMAT_YUV_MASK, LB_W_3073_INF), 12},
-    {sramAmountParams(TDM_ATTR_SCALE, FORMAT_RGB_MASK, LB_W_3073_INF), 16}};
 } // namespace zuma
 
 #endif // ANDROID_EXYNOS_HWC_MODULE_ZUMA_H_
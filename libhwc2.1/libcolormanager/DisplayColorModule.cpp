@@ -18,6 +18,8 @@
 
 #include <drm/samsung_drm.h>
 
+#include "LutPacker.h"
+
 using namespace android;
 namespace gs {
 
@@ -60,12 +62,15 @@ int32_t ColorDrmBlobFactory::eotf(const GsInterfaceType::IDpp::EotfData::ConfigT
     }
     eotfLut.scaler = config->eotf_scalar;
     eotfLut.lut_en = config->eotf_lut_en;
-    for (uint32_t i = 0; i < DRM_SAMSUNG_HDR_EOTF_V2P2_LUT_LEN; i++) {
-        eotfLut.ts[i].even = config->tf_data.posx[2 * i];
-        eotfLut.ts[i].odd = config->tf_data.posx[2 * i + 1];
-        eotfLut.vs[i].even = config->tf_data.posy[2 * i];
-        eotfLut.vs[i].odd = config->tf_data.posy[2 * i + 1];
-    }
+    packEvenOdd(eotfLut.ts, DRM_SAMSUNG_HDR_EOTF_V2P2_LUT_LEN, config->tf_data.posx.data(),
+                config->tf_data.posx.size());
+    packEvenOdd(eotfLut.vs, DRM_SAMSUNG_HDR_EOTF_V2P2_LUT_LEN, config->tf_data.posy.data(),
+                config->tf_data.posy.size());
+    /*
+     * There is one point fewer than the LUT holds, so the last odd points have no source.
+     * vs has always been 0 there. ts used to be read from past the end of posx.
+     */
+    eotfLut.ts[DRM_SAMSUNG_HDR_EOTF_V2P2_LUT_LEN - 1].odd = 0;
     eotfLut.vs[DRM_SAMSUNG_HDR_EOTF_V2P2_LUT_LEN - 1].odd = 0;
     int ret = drm->CreatePropertyBlob(&eotfLut, sizeof(eotfLut), &blobId);
     if (ret) {
@@ -114,12 +119,10 @@ int32_t ColorDrmBlobFactory::dtm(const GsInterfaceType::IDpp::DtmData::ConfigTyp
         return -EINVAL;
     }
 
-    for (uint32_t i = 0; i < DRM_SAMSUNG_HDR_TM_V2P2_LUT_LEN; i++) {
-        tmData.ts[i].even = config->tf_data.posx[2 * i];
-        tmData.ts[i].odd = config->tf_data.posx[2 * i + 1];
-        tmData.vs[i].even = config->tf_data.posy[2 * i];
-        tmData.vs[i].odd = config->tf_data.posy[2 * i + 1];
-    }
+    packEvenOdd(tmData.ts, DRM_SAMSUNG_HDR_TM_V2P2_LUT_LEN, config->tf_data.posx.data(),
+                config->tf_data.posx.size());
+    packEvenOdd(tmData.vs, DRM_SAMSUNG_HDR_TM_V2P2_LUT_LEN, config->tf_data.posy.data(),
+                config->tf_data.posy.size());
     tmData.coeff_00 = config->coeff_r;
     tmData.coeff_01 = config->coeff_g;
     tmData.coeff_02 = config->coeff_b;
@@ -152,12 +155,10 @@ int32_t ColorDrmBlobFactory::oetf(const GsInterfaceType::IDpp::OetfData::ConfigT
         return -EINVAL;
     }
 
-    for (uint32_t i = 0; i < DRM_SAMSUNG_HDR_OETF_V2P2_LUT_LEN; i++) {
-        oetfLut.ts[i].even = config->tf_data.posx[2 * i];
-        oetfLut.ts[i].odd = config->tf_data.posx[2 * i + 1];
-        oetfLut.vs[i].even = config->tf_data.posy[2 * i];
-        oetfLut.vs[i].odd = config->tf_data.posy[2 * i + 1];
-    }
+    packEvenOdd(oetfLut.ts, DRM_SAMSUNG_HDR_OETF_V2P2_LUT_LEN, config->tf_data.posx.data(),
+                config->tf_data.posx.size());
+    packEvenOdd(oetfLut.vs, DRM_SAMSUNG_HDR_OETF_V2P2_LUT_LEN, config->tf_data.posy.data(),
+                config->tf_data.posy.size());
     int ret = drm->CreatePropertyBlob(&oetfLut, sizeof(oetfLut), &blobId);
     if (ret) {
         ALOGE("Failed to create oetf lut blob %d", ret);
@@ -199,10 +200,9 @@ int32_t ColorDrmBlobFactory::degamma(
     }
 
     struct drm_color_lut colorLut[ConfigType::kLutLen * 2];
-    for (uint32_t i = 0; i < ConfigType::kLutLen; i++) {
-        colorLut[i].red = config->values.posx[i];
-        colorLut[i + ConfigType::kLutLen].red = config->values.posy[i];
-    }
+    packColorLut(colorLut, ConfigType::kLutLen, config->values.posx.data(), nullptr, nullptr);
+    packColorLut(colorLut + ConfigType::kLutLen, ConfigType::kLutLen,
+                 config->values.posy.data(), nullptr, nullptr);
     int ret = drm->CreatePropertyBlob(colorLut, sizeof(colorLut), &blobId);
     if (ret) {
         ALOGE("Failed to create degamma lut blob %d", ret);
@@ -292,14 +292,11 @@ int32_t ColorDrmBlobFactory::regamma(
     }
 
     struct drm_color_lut colorLut[ConfigType::kChannelLutLen * 2];
-    for (uint32_t i = 0; i < ConfigType::kChannelLutLen; i++) {
-        colorLut[i].red = config->r_values.posx[i];
-        colorLut[i].green = config->g_values.posx[i];
-        colorLut[i].blue = config->b_values.posx[i];
-        colorLut[i + ConfigType::kChannelLutLen].red = config->r_values.posy[i];
-        colorLut[i + ConfigType::kChannelLutLen].green = config->g_values.posy[i];
-        colorLut[i + ConfigType::kChannelLutLen].blue = config->b_values.posy[i];
-    }
+    packColorLut(colorLut, ConfigType::kChannelLutLen, config->r_values.posx.data(),
+                 config->g_values.posx.data(), config->b_values.posx.data());
+    packColorLut(colorLut + ConfigType::kChannelLutLen, ConfigType::kChannelLutLen,
+                 config->r_values.posy.data(), config->g_values.posy.data(),
+                 config->b_values.posy.data());
     int ret = drm->CreatePropertyBlob(colorLut, sizeof(colorLut), &blobId);
     if (ret) {
         ALOGE("Failed to create regamma lut blob %d", ret);
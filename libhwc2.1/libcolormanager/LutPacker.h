@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <drm/drm_mode.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace gs {
+
+/*
+ * Packing of displaycolor LUT points into the layouts of the samsung_drm blobs.
+ * Both helpers produce exactly what the element by element loops they replace did, with
+ * points missing from a short source left as 0.
+ */
+
+/*
+ * dst[i].even = src[2 * i], dst[i].odd = src[2 * i + 1] for dstLen pairs.
+ * A pair of two fields of the source width is the source sequence itself and is copied;
+ * otherwise the points are widened, with NEON where available.
+ */
+template <typename Pair, typename Src>
+void packEvenOdd(Pair *dst, size_t dstLen, const Src *src, size_t srcLen) {
+    using Even = decltype(Pair::even);
+    using Odd = decltype(Pair::odd);
+    static_assert(std::is_standard_layout_v<Pair>);
+    static_assert(std::is_same_v<Even, Odd> && std::is_unsigned_v<Even>);
+
+    const size_t count = std::min(srcLen, 2 * dstLen);
+    constexpr bool kContiguous = (offsetof(Pair, even) == 0) &&
+            (offsetof(Pair, odd) == sizeof(Even)) && (sizeof(Pair) == 2 * sizeof(Even));
+    Even *out = reinterpret_cast<Even *>(dst);
+
+    if constexpr (kContiguous && sizeof(Even) == sizeof(Src)) {
+        memcpy(out, src, count * sizeof(Src));
+    } else if constexpr (kContiguous) {
+        size_t i = 0;
+#if defined(__ARM_NEON)
+        if constexpr (std::is_same_v<Src, uint16_t> && std::is_same_v<Even, uint32_t>) {
+            for (; i + 8 <= count; i += 8) {
+                const uint16x8_t points = vld1q_u16(src + i);
+                vst1q_u32(out + i, vmovl_u16(vget_low_u16(points)));
+                vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(points)));
+            }
+        }
+#endif
+        for (; i < count; i++) out[i] = src[i];
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            if (i & 1)
+                dst[i / 2].odd = src[i];
+            else
+                dst[i / 2].even = src[i];
+        }
+        for (size_t i = count; i < 2 * dstLen; i++) {
+            if (i & 1)
+                dst[i / 2].odd = 0;
+            else
+                dst[i / 2].even = 0;
+        }
+        return;
+    }
+    for (size_t i = count; i < 2 * dstLen; i++) out[i] = 0;
+}
+
+/*
+ * dst[i] = {red[i], green[i], blue[i], 0} for len entries, a null channel is packed as 0.
+ */
+inline void packColorLut(struct drm_color_lut *dst, size_t len, const uint16_t *red,
+                         const uint16_t *green, const uint16_t *blue) {
+    static_assert(sizeof(struct drm_color_lut) == 4 * sizeof(uint16_t));
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    const uint16x8_t zero = vdupq_n_u16(0);
+    for (; i + 8 <= len; i += 8) {
+        uint16x8x4_t lanes;
+        lanes.val[0] = red ? vld1q_u16(red + i) : zero;
+        lanes.val[1] = green ? vld1q_u16(green + i) : zero;
+        lanes.val[2] = blue ? vld1q_u16(blue + i) : zero;
+        lanes.val[3] = zero;
+        vst4q_u16(reinterpret_cast<uint16_t *>(dst + i), lanes);
+    }
+#endif
+    if (red && green && blue) {
+        /* Regamma, kept free of per point checks so the compiler can vectorize it */
+        for (; i < len; i++) dst[i] = {red[i], green[i], blue[i], 0};
+        return;
+    }
+    for (; i < len; i++) {
+        dst[i].red = red ? red[i] : 0;
+        dst[i].green = green ? green[i] : 0;
+        dst[i].blue = blue ? blue[i] : 0;
+        dst[i].reserved = 0;
+    }
+}
+
+} // namespace gs
@@ -16,6 +16,8 @@
 //#define LOG_NDEBUG 0
 #include "ExynosExternalDisplayModule.h"
 
+#include "../libresource/ExynosResourceManagerModule.h"
+
 using namespace zuma;
 
 ExynosExternalDisplayModule::ExynosExternalDisplayModule(uint32_t index, ExynosDevice* device,
@@ -31,3 +33,17 @@ int32_t ExynosExternalDisplayModule::validateWinConfigData()
 {
     return ExynosDisplay::validateWinConfigData();
 }
+
+int32_t ExynosExternalDisplayModule::validateDisplay(uint32_t* outNumTypes,
+                                                     uint32_t* outNumRequests) {
+    static_cast<ExynosResourceManagerModule*>(mDevice->mResourceManager)->onTDMValidate(this);
+    return gs201::ExynosExternalDisplayModule::validateDisplay(outNumTypes, outNumRequests);
+}
+
+int ExynosExternalDisplayModule::deliverWinConfigData() {
+    /* Called by presentDisplay() with the display locked, the assignment is committed */
+    int ret = gs201::ExynosExternalDisplayModule::deliverWinConfigData();
+    if (ret == NO_ERROR)
+        static_cast<ExynosResourceManagerModule*>(mDevice->mResourceManager)->onTDMPresent(this);
+    return ret;
+}
@@ -27,6 +27,8 @@ class ExynosExternalDisplayModule : public gs201::ExynosExternalDisplayModule {
                                     const std::string& displayName);
         ~ExynosExternalDisplayModule();
         virtual int32_t validateWinConfigData();
+        int32_t validateDisplay(uint32_t* outNumTypes, uint32_t* outNumRequests) override;
+        int deliverWinConfigData() override;
 };
 
 }  // namespace zuma
@@ -21,6 +21,7 @@
 #include <cutils/properties.h>
 
 #include "ExynosHWCHelper.h"
+#include "../libresource/ExynosResourceManagerModule.h"
 
 #define OP_MANAGER_LOGD(msg, ...)                                                         \
     ALOGD("[%s] OperationRateManager::%s:" msg, mDisplay->mDisplayName.c_str(), __func__, \
@@ -55,6 +56,20 @@ int32_t ExynosPrimaryDisplayModule::validateWinConfigData()
     return ExynosDisplay::validateWinConfigData();
 }
 
+int32_t ExynosPrimaryDisplayModule::validateDisplay(uint32_t* outNumTypes,
+                                                    uint32_t* outNumRequests) {
+    static_cast<ExynosResourceManagerModule*>(mDevice->mResourceManager)->onTDMValidate(this);
+    return gs201::ExynosPrimaryDisplayModule::validateDisplay(outNumTypes, outNumRequests);
+}
+
+int ExynosPrimaryDisplayModule::deliverWinConfigData() {
+    /* Called by presentDisplay() with the display locked, the assignment is committed */
+    int ret = gs201::ExynosPrimaryDisplayModule::deliverWinConfigData();
+    if (ret == NO_ERROR)
+        static_cast<ExynosResourceManagerModule*>(mDevice->mResourceManager)->onTDMPresent(this);
+    return ret;
+}
+
 int32_t ExynosPrimaryDisplayModule::OperationRateManager::getTargetOperationRate() const {
     if (mDisplayPowerMode == HWC2_POWER_MODE_DOZE ||
         mDisplayPowerMode == HWC2_POWER_MODE_DOZE_SUSPEND) {
@@ -29,6 +29,8 @@ class ExynosPrimaryDisplayModule : public gs201::ExynosPrimaryDisplayModule {
                                    const std::string& displayName);
         ~ExynosPrimaryDisplayModule();
         virtual int32_t validateWinConfigData();
+        int32_t validateDisplay(uint32_t* outNumTypes, uint32_t* outNumRequests) override;
+        int deliverWinConfigData() override;
         void checkPreblendingRequirement() override;
 
     protected:
@@ -14,10 +14,14 @@
  * limitations under the License.
  */
 
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+
 #include "ExynosResourceManagerModule.h"
 
 #include <cutils/properties.h>
+#include <utils/Trace.h>
 
+#include <algorithm>
 #include <list>
 #include <utility>
 
@@ -25,7 +29,13 @@
 
 using namespace zuma;
 
-constexpr uint32_t TDM_OVERLAP_MARGIN = 68;
+/*
+ * Share of the uncompressed size read for compressed buffers. These are placeholders, not
+ * measured ratios, so the bandwidth term of otfMppReordering() is off by default.
+ */
+constexpr uint64_t kAFBCReadPercent = 60;
+constexpr uint64_t kSBWCReadPercent = 60;
+constexpr uint32_t kDefaultRefreshRate = 60;
 
 constexpr uint32_t kSramSBWCWidthAlign = 32;
 constexpr uint32_t kSramSBWCWidthMargin = kSramSBWCWidthAlign - 1;
@@ -48,67 +58,144 @@ ExynosResourceManagerModule::ExynosResourceManagerModule(ExynosDevice *device)
     HWAttrs.at(TDM_ATTR_WCG).loadSharing =
             (mConstraintRev == CONSTRAINT_A0) ? LS_DPUF : LS_DPUF_AXI;
     ALOGD("%s(): ro.boot.hw.soc.rev=%s ConstraintRev=%d", __func__, value, mConstraintRev);
+
+    mOptimalOtfAssign = property_get_bool("vendor.display.tdm.optimal_assign", false);
+    mReuseTDMDecisions = property_get_bool("vendor.display.tdm.reuse_decisions", true);
+    mBandwidthBalancing = property_get_bool("vendor.display.tdm.bw_balancing", false);
+    mFixedOverlapMargin = property_get_bool("vendor.display.tdm.fixed_overlap_margin", true);
+    mJointPlanning = property_get_bool("vendor.display.tdm.joint_planning", true);
+    mDemandSplit = property_get_bool("vendor.display.tdm.demand_split", true);
+    for (auto &reach : mTDMReachDump) reach.store(kNoTDMReach, std::memory_order_relaxed);
+    mCacheTDMRejections = property_get_bool("vendor.display.tdm.rejection_cache", true);
+    mFilterOtfCandidates = property_get_bool("vendor.display.tdm.candidate_mask", true);
+    setPackingPolicy(static_cast<packingPolicy_t>(
+            property_get_int32("vendor.display.tdm.packing_policy", PACKING_SPREAD)));
+    mPackingMaxLayers = property_get_int32("vendor.display.tdm.packing_max_layers", 4);
+    mPartialUpdateTDM = property_get_bool("vendor.display.tdm.partial_update", false);
+    mTDMCallStats = property_get_bool("vendor.display.tdm.call_stats", false);
+
+    for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
+        mTDMUtilization.setAttrName(attr->first, attr->second.name.c_str());
+        mTDMRejectionLog.setAttrName(attr->first, attr->second.name.c_str());
+        if (attr->second.loadSharing == LS_DPUF_AXI) mPerAXIAttrMask |= 1u << attr->first;
+    }
 }
 
 ExynosResourceManagerModule::~ExynosResourceManagerModule() {}
 
 bool ExynosResourceManagerModule::checkTDMResource(ExynosDisplay *display, ExynosMPP *currentMPP,
-                                                   ExynosMPPSource *mppSrc) {
-    std::array<uint32_t, TDM_ATTR_MAX> accumulatedDPUFAmount{};
-    std::array<uint32_t, TDM_ATTR_MAX> accumulatedDPUFAXIAmount{};
+                                                   ExynosMPPSource *mppSrc,
+                                                   const TDMOccupancy *occupancy) {
+    TDMAmounts accumulatedDPUFAmount;
+    TDMAmounts accumulatedDPUFAXIAmount;
     const uint32_t blkId = currentMPP->getHWBlockId();
     const uint32_t axiId = currentMPP->getAXIPortId();
     HDEBUGLOGD(eDebugTDM, "%s : %p trying to assign to %s, compare with layers", __func__,
                mppSrc->mSrcImg.bufferHandle, currentMPP->mName.c_str());
     ExynosLayer *layer = (mppSrc->mSourceType == MPP_SOURCE_LAYER) ? (ExynosLayer *)mppSrc : nullptr;
 
-    for (auto compLayer : display->mLayers) {
-        ExynosMPP *otfMPP = compLayer->mOtfMPP;
-        if (!otfMPP || layer == compLayer) continue;
-        getAmounts(display, blkId, axiId, otfMPP, mppSrc, compLayer,
-                   accumulatedDPUFAmount, accumulatedDPUFAXIAmount);
+    /*
+     * The result only depends on the source, the MPP and the sources in its DPUF, so a
+     * combination rejected before is rejected without accumulating the amounts again.
+     */
+    uint64_t rejectionKey = 0xcbf29ce484222325ULL;
+    const bool cacheRejection = mCacheTDMRejections && (occupancy == &mTDMOccupancy) &&
+            occupancy->isValid() && (blkId < DPU_BLOCK_CNT);
+    if (cacheRejection) {
+        getTDMRejectionState(display, currentMPP, mppSrc, mTDMRejectionState);
+        for (auto word : mTDMRejectionState) hashTDMState(rejectionKey, word);
+        /* Like a decision, a hit is only trusted once the full state is confirmed */
+        const auto &rejection = mTDMRejections.find(rejectionKey);
+        if ((rejection != mTDMRejections.end()) &&
+            (rejection->second.state == mTDMRejectionState)) {
+            mTDMStats.rejectionCacheHits.add();
+            mTDMStats.rejectedBy[rejection->second.attr].add();
+            mTDMRejectedBy = rejection->second.attr;
+            return false;
+        }
+        mTDMStats.rejectionCacheMisses.add();
     }
 
-    if (display->mExynosCompositionInfo.mHasCompositionLayer) {
-        HDEBUGLOGD(eDebugTDM,
-                   "%s : %p trying to assign to %s, compare with ExynosComposition Target buffer",
-                   __func__, mppSrc->mSrcImg.bufferHandle, currentMPP->mName.c_str());
-        ExynosMPP *otfMPP = display->mExynosCompositionInfo.mOtfMPP;
-        if (otfMPP)
-            getAmounts(display, blkId, axiId, otfMPP, mppSrc, &display->mExynosCompositionInfo,
+    if ((occupancy == nullptr) ||
+        !getOccupiedAmounts(display, blkId, axiId, mppSrc, *occupancy, accumulatedDPUFAmount,
+                            accumulatedDPUFAXIAmount)) {
+        for (auto compLayer : display->mLayers) {
+            ExynosMPP *otfMPP = compLayer->mOtfMPP;
+            if (!otfMPP || layer == compLayer) continue;
+            getAmounts(display, blkId, axiId, otfMPP, mppSrc, compLayer,
                        accumulatedDPUFAmount, accumulatedDPUFAXIAmount);
+        }
+
+        if (display->mExynosCompositionInfo.mHasCompositionLayer) {
+            HDEBUGLOGD(eDebugTDM,
+                       "%s : %p trying to assign to %s, compare with ExynosComposition Target "
+                       "buffer",
+                       __func__, mppSrc->mSrcImg.bufferHandle, currentMPP->mName.c_str());
+            ExynosMPP *otfMPP = display->mExynosCompositionInfo.mOtfMPP;
+            if (otfMPP)
+                getAmounts(display, blkId, axiId, otfMPP, mppSrc,
+                           &display->mExynosCompositionInfo, accumulatedDPUFAmount,
+                           accumulatedDPUFAXIAmount);
+        }
+
+        if (display->mClientCompositionInfo.mHasCompositionLayer) {
+            HDEBUGLOGD(eDebugTDM,
+                       "%s : %p trying to assign to %s, compare with ClientComposition Target "
+                       "buffer",
+                       __func__, mppSrc->mSrcImg.bufferHandle, currentMPP->mName.c_str());
+            ExynosMPP *otfMPP = display->mClientCompositionInfo.mOtfMPP;
+            if (otfMPP)
+                getAmounts(display, blkId, axiId, otfMPP, mppSrc,
+                           &display->mClientCompositionInfo, accumulatedDPUFAmount,
+                           accumulatedDPUFAXIAmount);
+        }
     }
 
-    if (display->mClientCompositionInfo.mHasCompositionLayer) {
-        HDEBUGLOGD(eDebugTDM,
-                   "%s : %p trying to assign to %s, compare with ClientComposition Target buffer",
-                   __func__, mppSrc->mSrcImg.bufferHandle, currentMPP->mName.c_str());
-        ExynosMPP *otfMPP = display->mClientCompositionInfo.mOtfMPP;
-        if (otfMPP)
-            getAmounts(display, blkId, axiId, otfMPP, mppSrc, &display->mClientCompositionInfo,
-                       accumulatedDPUFAmount, accumulatedDPUFAXIAmount);
+    const TDMAmounts currentAmount = getTDMAmounts(mppSrc);
+    const TDMAmounts accumulatedAmount =
+            TDMAmounts::select(mPerAXIAttrMask, accumulatedDPUFAXIAmount, accumulatedDPUFAmount);
+    const TDMAmounts &totalAmount = getTDMBudget(display, blkId, axiId);
+    const TDMAmounts usedAmount = accumulatedAmount + currentAmount;
+    const uint32_t exceeded = usedAmount.greaterThan(totalAmount);
+
+    if (hwcCheckDebugMessages(eDebugTDM)) {
+        for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
+            HDEBUGLOGD(eDebugTDM,
+                       "%s, layer[%p] -> %s attr[%s],ls=%d,accumulated:%d,current:%d,total: %d",
+                       __func__, mppSrc->mSrcImg.bufferHandle, currentMPP->mName.c_str(),
+                       attr->second.name.c_str(), attr->second.loadSharing,
+                       accumulatedAmount[attr->first], currentAmount[attr->first],
+                       totalAmount[attr->first]);
+        }
     }
 
-    for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
-        const LoadSharing_t &loadSharing = attr->second.loadSharing;
-        uint32_t currentAmount = mppSrc->getHWResourceAmount(attr->first);
-        auto &accumulatedAmount =
-                (loadSharing == LS_DPUF) ? accumulatedDPUFAmount : accumulatedDPUFAXIAmount;
-        const auto &TDMInfoIdx =
-                std::make_pair(blkId,
-                               (loadSharing == LS_DPUF) ? AXI_DONT_CARE : axiId);
-        int32_t totalAmount =
-                display->mDisplayTDMInfo[TDMInfoIdx].getAvailableAmount(attr->first).totalAmount;
-        HDEBUGLOGD(eDebugTDM,
-                   "%s, layer[%p] -> %s attr[%s],ls=%d,accumulated:%d,current:%d,total: %d",
-                   __func__, mppSrc->mSrcImg.bufferHandle, currentMPP->mName.c_str(),
-                   attr->second.name.c_str(), loadSharing, accumulatedAmount[attr->first],
-                   currentAmount, totalAmount);
-        if (accumulatedAmount[attr->first] + currentAmount > totalAmount) {
-            HDEBUGLOGD(eDebugTDM, "%s, %s could not assigned by attr[%s]", __func__,
-                       currentMPP->mName.c_str(), attr->second.name.c_str());
-            return false;
+    if (exceeded) {
+        /* The first attribute in HWAttrs order, like checking them one by one */
+        const tdm_attr_t attrId = static_cast<tdm_attr_t>(__builtin_ctz(exceeded));
+        const auto &attr = HWAttrs.at(attrId);
+        HDEBUGLOGD(eDebugTDM, "%s, %s could not assigned by attr[%s]", __func__,
+                   currentMPP->mName.c_str(), attr.name.c_str());
+        mTDMStats.rejectedBy[attrId].add();
+        mTDMRejectedBy = attrId;
+        TDMRejectionLog::Event event{};
+        event.timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
+        event.source = mppSrc;
+        event.bufferHandle = mppSrc->mSrcImg.bufferHandle;
+        TDMRejectionLog::setName(event.displayName, display->mDisplayName.c_str());
+        TDMRejectionLog::setName(event.mppName, currentMPP->mName.c_str());
+        event.attr = attrId;
+        event.blockId = blkId;
+        event.axiId = (attr.loadSharing == LS_DPUF) ? static_cast<uint32_t>(AXI_DONT_CARE) : axiId;
+        event.accumulated = accumulatedAmount[attrId];
+        event.current = currentAmount[attrId];
+        event.total = totalAmount[attrId];
+        mTDMRejectionLog.record(event);
+        if (cacheRejection) {
+            if (mTDMRejections.size() >= kMaxTDMRejections) mTDMRejections.clear();
+            /* A colliding key is replaced, it would never be confirmed */
+            mTDMRejections[rejectionKey] = TDMRejection{mTDMRejectionState, attrId};
         }
+        return false;
     }
 
     HDEBUGLOGD(eDebugTDM, "%s : %p trying to assign to %s successfully", __func__,
@@ -119,18 +206,127 @@ bool ExynosResourceManagerModule::checkTDMResource(ExynosDisplay *display, Exyno
 bool ExynosResourceManagerModule::isHWResourceAvailable(ExynosDisplay *display,
                                                         ExynosMPP *currentMPP,
                                                         ExynosMPPSource *mppSrc) {
-    if (!checkTDMResource(display, currentMPP, mppSrc)) {
+    /* Channels that cannot take the layer at all don't need the TDM check */
+    if (isFilteredOtfCandidate(display, currentMPP, mppSrc)) {
+        mTDMStats.filteredCandidates.add();
         return false;
     }
 
+    TDMStatsScope statsScope(mTDMStats.availability, mTDMCallStats);
+    prepareTDMChecks(display);
+
+    /*
+     * The result only depends on the stack and assignment state of the display. The stack is
+     * compared once per validate by prepareTDMChecks(), so a decision is reused for the same
+     * candidate and source if the assignment is the same. Debug messages need the check.
+     */
+    if (!mReuseTDMDecisions || hwcCheckDebugMessages(eDebugTDM)) {
+        const bool available = checkHWResourceAvailable(display, currentMPP, mppSrc);
+        statsScope.setPassed(available);
+        return available;
+    }
+
+    getTDMAssignmentState(display, mTDMAssignmentState);
+    uint64_t key = 0xcbf29ce484222325ULL;
+    hashTDMState(key, reinterpret_cast<uintptr_t>(currentMPP));
+    hashTDMState(key, reinterpret_cast<uintptr_t>(mppSrc));
+    for (auto word : mTDMAssignmentState) hashTDMState(key, word);
+
+    auto &decisions = mTDMDecisions[display].decisions;
+    const auto &decision = decisions.find(key);
+    if ((decision != decisions.end()) && (decision->second.currentMPP == currentMPP) &&
+        (decision->second.mppSrc == mppSrc) &&
+        (decision->second.assignment == mTDMAssignmentState)) {
+        mTDMStats.reusedDecisions.add();
+        if (decision->second.rejectedBy < TDM_ATTR_MAX)
+            mTDMStats.rejectedBy[decision->second.rejectedBy].add();
+        statsScope.setPassed(decision->second.available);
+        return decision->second.available;
+    }
+
+    mTDMRejectedBy = TDM_ATTR_MAX;
+    const bool available = checkHWResourceAvailable(display, currentMPP, mppSrc);
+    statsScope.setPassed(available);
+    if (decisions.size() >= kMaxTDMDecisions) decisions.clear();
+    /* A colliding key is replaced, it would never be confirmed */
+    decisions[key] = TDMDecision{currentMPP, mppSrc, mTDMAssignmentState, available,
+                                 available ? TDM_ATTR_MAX : mTDMRejectedBy};
+    return available;
+}
+
+void ExynosResourceManagerModule::prepareTDMChecks(ExynosDisplay *display) {
+    /*
+     * Validates of displays without onTDMValidate(), e.g. virtual displays, can't be told
+     * apart, so their stack is compared at every check and a changed one starts a validate
+     */
+    const uint32_t displaySlot = getTDMDisplaySlot(display);
+    const bool hooked = (displaySlot < 32) && ((mTDMValidateHooks >> displaySlot) & 1);
+    bool newValidate = false;
+    if (mTDMCheckDisplay != display) {
+        mTDMCheckDisplay = display;
+        mTDMChecksPending = true;
+        newValidate = !hooked;
+    }
+    if (!hooked) mTDMChecksPending = true;
+    if (!mTDMChecksPending) return;
+    mTDMChecksPending = false;
+
+    /* Partial update can still be cancelled until present, check the full frame */
+    mTDMUpdateRegion.display = nullptr;
+    /* Decisions of another stack can't be reused, compare it in full instead of a hash */
+    getTDMStackState(display, mTDMStackState);
+    auto &cache = mTDMDecisions[display];
+    if (cache.stack != mTDMStackState) {
+        cache.stack.swap(mTDMStackState);
+        cache.decisions.clear();
+        newValidate = !hooked;
+    }
+    if (!newValidate) return;
+
+    /* A split clears the decisions and the update region, prepare them again */
+    updateTDMDemand(display);
+    if (mTDMChecksPending) prepareTDMChecks(display);
+}
+
+bool ExynosResourceManagerModule::checkHWResourceAvailable(ExynosDisplay *display,
+                                                           ExynosMPP *currentMPP,
+                                                           ExynosMPPSource *mppSrc) {
+    ATRACE_CALL();
+
+    /*
+     * Overlapped layers are checked again below, index the assigned sources once so that
+     * each check doesn't walk every layer. Debug messages need the per-layer walk.
+     */
+    const TDMOccupancy *occupancy = nullptr;
+    if (!hwcCheckDebugMessages(eDebugTDM)) {
+        buildTDMOccupancy(display);
+        occupancy = &mTDMOccupancy;
+    }
+
+    if (!checkTDMResource(display, currentMPP, mppSrc, occupancy)) return false;
+
     std::list<ExynosLayer *> overlappedLayers;
     uint32_t currentBlockId = currentMPP->getHWBlockId();
-    for (auto layer : display->mLayers) {
-        ExynosMPP *otfMPP = layer->mOtfMPP;
-        if (!otfMPP || dynamic_cast<ExynosMPPSource *>(layer) == mppSrc) continue;
+    int32_t top, bottom;
+    getTDMSpan(display, mppSrc->mSrcImg, mppSrc->mDstImg, top, bottom);
+    uint32_t overlapped = 0;
+    if (occupancy && occupancy->getOverlapMask(currentBlockId, top, bottom, overlapped)) {
+        /* Sources are numbered in mLayers order, like the walk below */
+        while (overlapped) {
+            ExynosLayer *layer = mTDMOccupancyLayers[__builtin_ctz(overlapped)];
+            overlapped &= overlapped - 1;
+            if (layer && (dynamic_cast<ExynosMPPSource *>(layer) != mppSrc))
+                overlappedLayers.push_back(layer);
+        }
+    } else {
+        for (auto layer : display->mLayers) {
+            ExynosMPP *otfMPP = layer->mOtfMPP;
+            if (!otfMPP || dynamic_cast<ExynosMPPSource *>(layer) == mppSrc) continue;
 
-        if ((currentBlockId == otfMPP->getHWBlockId()) && isOverlapped(display, mppSrc, layer))
-            overlappedLayers.push_back(layer);
+            if ((currentBlockId == otfMPP->getHWBlockId()) &&
+                isOverlapped(display, mppSrc, layer))
+                overlappedLayers.push_back(layer);
+        }
     }
 
     if (overlappedLayers.size()) {
@@ -142,89 +338,551 @@ bool ExynosResourceManagerModule::isHWResourceAvailable(ExynosDisplay *display,
         for (auto &overlappedLayer : overlappedLayers) {
             HDEBUGLOGD(eDebugTDM, "%s : %p overlapped %p", __func__, mppSrc->mSrcImg.bufferHandle,
                        overlappedLayer->mLayerBuffer);
-            if (!checkTDMResource(display, overlappedLayer->mOtfMPP, overlappedLayer)) {
+            if (!checkTDMResource(display, overlappedLayer->mOtfMPP, overlappedLayer,
+                                  occupancy))
                 return false;
-            }
         }
     }
+
     return true;
 }
 
+void ExynosResourceManagerModule::onTDMPresent(ExynosDisplay *display) {
+    /* The update region is taken again below, the next check prepares its own */
+    mTDMCheckDisplay = nullptr;
+    mOtfCandidates = {nullptr, nullptr, kAllOtfCandidates};
+
+    const uint32_t displaySlot = getTDMDisplaySlot(display);
+    if (displaySlot >= TDMUtilization::kMaxDisplays) return;
+
+    /* The assignment and update region are final, sample the busiest scanline once */
+    updateTDMUpdateRegion(display);
+    TDMPresentState &present = mTDMPresents[displaySlot];
+    const uint64_t hash = getTDMPresentHash(display);
+    if (!present.valid || (present.hash != hash)) {
+        present.valid = true;
+        present.hash = hash;
+        present.samples.clear();
+        buildTDMOccupancy(display);
+        auto sampleSource = [&](ExynosMPP *otfMPP, ExynosMPPSource *src) {
+            const uint32_t blockId = otfMPP->getHWBlockId();
+            if (blockId >= DPU_BLOCK_CNT) return;
+            int32_t top, bottom;
+            getTDMSpan(display, src->mSrcImg, src->mDstImg, top, bottom);
+            if (top > bottom) return;
+            for (uint32_t axiId = 0; axiId < AXI_PORT_MAX_CNT; axiId++) {
+                TDMAmounts DPUFAmounts;
+                TDMAmounts AXIAmounts;
+                if (!mTDMOccupancy.query(blockId, axiId, top, bottom, DPUFAmounts, AXIAmounts))
+                    return;
+                const TDMAmounts &totalAmount = getTDMBudget(display, blockId, axiId);
+                for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
+                    const bool perAXI = (mPerAXIAttrMask >> attr->first) & 1;
+                    /* LS_DPUF budgets are the same for every AXI port */
+                    if (!perAXI && (axiId != 0)) continue;
+                    present.samples.push_back(
+                            {attr->first, blockId,
+                             perAXI ? axiId : static_cast<uint32_t>(AXI_DONT_CARE),
+                             (perAXI ? AXIAmounts : DPUFAmounts)[attr->first],
+                             totalAmount[attr->first]});
+                }
+            }
+        };
+
+        for (auto layer : display->mLayers) {
+            if (layer->mOtfMPP) sampleSource(layer->mOtfMPP, layer);
+        }
+        for (ExynosCompositionInfo *info :
+             {&display->mExynosCompositionInfo, &display->mClientCompositionInfo}) {
+            if (info->mHasCompositionLayer && info->mOtfMPP) sampleSource(info->mOtfMPP, info);
+        }
+    }
+
+    /* The same assignment takes the same share of the same budgets */
+    for (const auto &sample : present.samples) {
+        mTDMUtilization.sample(displaySlot, sample.attr, sample.blockId, sample.axiId,
+                               sample.used, sample.total);
+    }
+    mTDMUtilization.endFrame(displaySlot, display->mDisplayName.c_str());
+}
+
+uint64_t ExynosResourceManagerModule::getTDMPresentHash(ExynosDisplay *display) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto hashSource = [&](ExynosMPPSource *src) {
+        hashTDMState(hash, reinterpret_cast<uintptr_t>(src));
+        hashTDMSource(hash, src);
+    };
+    for (auto layer : display->mLayers) {
+        if (layer->mOtfMPP) hashSource(layer);
+    }
+    for (ExynosCompositionInfo *info :
+         {&display->mExynosCompositionInfo, &display->mClientCompositionInfo}) {
+        if (info->mHasCompositionLayer && info->mOtfMPP) hashSource(info);
+    }
+    if (mTDMUpdateRegion.display == display)
+        hashTDMState(hash, (static_cast<uint64_t>(mTDMUpdateRegion.top) << 32) |
+                             static_cast<uint32_t>(mTDMUpdateRegion.bottom));
+    /* Budgets are split again at validates of other displays */
+    for (uint32_t blockId = 0; blockId < DPU_BLOCK_CNT; blockId++) {
+        for (uint32_t axiId = 0; axiId < AXI_PORT_MAX_CNT; axiId++) {
+            const TDMAmounts &budget = getTDMBudget(display, blockId, axiId);
+            for (size_t lane = 0; lane < TDMAmounts::kLanes; lane += 2)
+                hashTDMState(hash, (static_cast<uint64_t>(budget[lane]) << 32) | budget[lane + 1]);
+        }
+    }
+    return hash;
+}
+
 void ExynosResourceManagerModule::setupHWResource(const tdm_attr_t &tdmAttrId, const String8 &name,
                                                   const DPUblockId_t &blkId,
                                                   const AXIPortId_t &axiId, ExynosDisplay *display,
-                                                  ExynosDisplay *addedDisplay,
                                                   const ConstraintRev_t &constraintsRev) {
     const int32_t dispType = display->mType;
-    const auto &resourceIdx = HWResourceIndexes(tdmAttrId, blkId, axiId, dispType, constraintsRev);
-    const auto &iter = mHWResourceTables->find(resourceIdx);
-    if (iter != mHWResourceTables->end()) {
-        auto &hwResource = iter->second;
+    const auto *budget = getHWResourceBudget(*mHWResourceTables, tdmAttrId, blkId, axiId,
+                                             dispType, constraintsRev);
+    if (budget != nullptr) {
         const auto &TDMInfoIdx = (HWAttrs.at(tdmAttrId).loadSharing == LS_DPUF)
                 ? std::make_pair(blkId, AXI_DONT_CARE)
                 : std::make_pair(blkId, axiId);
-        uint32_t amount = (addedDisplay == nullptr) ? hwResource.maxAssignedAmount
-                                                    : hwResource.totalAmount -
-                        addedDisplay->mDisplayTDMInfo[TDMInfoIdx]
-                                .getAvailableAmount(tdmAttrId)
-                                .totalAmount;
+        uint32_t amount = budget->amounts.maxAssignedAmount;
         display->mDisplayTDMInfo[TDMInfoIdx].initTDMInfo(DisplayTDMInfo::ResourceAmount_t{amount},
                                                          tdmAttrId);
-        if (addedDisplay == nullptr) {
-            HDEBUGLOGD(eDebugTDM, "(%s=>%s) : %s amount is updated to %d",
-                       resourceIdx.toString8().c_str(), iter->first.toString8().c_str(),
-                       name.c_str(), amount);
-        } else {
-            HDEBUGLOGD(eDebugTDM, "(%s=>%s) : hwResource.totalAmount=%d %s amount is updated to %d",
-                       resourceIdx.toString8().c_str(), iter->first.toString8().c_str(),
-                       hwResource.totalAmount, name.c_str(), amount);
-        }
+        HDEBUGLOGD(eDebugTDM, "(%s) : %s amount is updated to %d",
+                   HWResourceIndexes(tdmAttrId, blkId, axiId, dispType, constraintsRev)
+                           .toString8()
+                           .c_str(),
+                   name.c_str(), amount);
     } else {
-        ALOGW("(%s): cannot find resource for %s", resourceIdx.toString8().c_str(), name.c_str());
+        ALOGW("(%s): cannot find resource for %s",
+              HWResourceIndexes(tdmAttrId, blkId, axiId, dispType, constraintsRev)
+                      .toString8()
+                      .c_str(),
+              name.c_str());
     }
 }
 
-uint32_t ExynosResourceManagerModule::setDisplaysTDMInfo()
-{
-    ExynosDisplay *addedDisplay = nullptr;
+std::vector<uint32_t> ExynosResourceManagerModule::getHWResourcePartition(
+        const tdm_attr_t &tdmAttrId, const String8 &name, const DPUblockId_t &blkId,
+        const AXIPortId_t &axiId, const std::vector<ExynosDisplay *> &displays,
+        const std::vector<uint32_t> &reachMasks, std::vector<TDMResourceRequest> &requests,
+        uint32_t &total) {
+    total = 0;
+    requests.assign(displays.size(), TDMResourceRequest{0, 0});
+    for (size_t i = 0; i < displays.size(); i++) {
+        ExynosDisplay *display = displays[i];
+        const auto *budget = getHWResourceBudget(*mHWResourceTables, tdmAttrId, blkId, axiId,
+                                                 display->mType, mConstraintRev);
+        auto &request = requests[i];
+        if (budget == nullptr) {
+            ALOGW("(%s): cannot find resource for %s",
+                  HWResourceIndexes(tdmAttrId, blkId, axiId, display->mType, mConstraintRev)
+                          .toString8()
+                          .c_str(),
+                  name.c_str());
+            continue;
+        }
+        /* Every display type has the same total, see HWResourceRules */
+        total = budget->amounts.totalAmount;
+        /* Channels of the resource are reserved for other displays */
+        if (!(reachMasks[i] & getTDMReachMask(blkId, axiId))) continue;
+        request.cap = budget->amounts.maxAssignedAmount;
+        /* The primary display takes what the others leave */
+        const bool primary = (display->mType == HWC_DISPLAY_PRIMARY) && (display->mIndex == 0);
+        const uint32_t slot = getTDMDisplaySlot(display);
+        if (!mDemandSplit || (slot >= mTDMDemands.size()) || !mTDMDemands[slot].known) {
+            request.reserve = primary ? 0 : request.cap;
+            continue;
+        }
+        /*
+         * Others reserve what their stack needs, nothing while they are idle, but never
+         * less than what they have on screen so that the split can't overcommit a frame
+         */
+        const TDMDemand &demand = mTDMDemands[slot];
+        const uint32_t axiIdx = (axiId == AXI_DONT_CARE) ? 0 : axiId;
+        const uint32_t assigned = demand.assigned.amounts[blkId][axiIdx][tdmAttrId];
+        const uint32_t needed = (primary || demand.idle) ? 0 : demand.stack[tdmAttrId];
+        request.reserve = std::max(needed, assigned);
+    }
 
-    /*
-     * Checking display connections,
-     * Assume that WFD and External are not connected at the same time
-     * If non-primary display is connected, primary display's HW resource is looted
-     */
-    for (auto &display : mDisplays) {
-        if (display->mType == HWC_DISPLAY_PRIMARY) continue;
-        if (display->isEnabled()) {
-            addedDisplay = display;
-            break;
+    return partitionTDMResource(total, requests);
+}
+
+void ExynosResourceManagerModule::partitionHWResource(const tdm_attr_t &tdmAttrId,
+                                                      const String8 &name,
+                                                      const DPUblockId_t &blkId,
+                                                      const AXIPortId_t &axiId,
+                                                      const std::vector<ExynosDisplay *> &displays,
+                                                      const std::vector<uint32_t> &reachMasks) {
+    const auto &TDMInfoIdx = (HWAttrs.at(tdmAttrId).loadSharing == LS_DPUF)
+            ? std::make_pair(blkId, AXI_DONT_CARE)
+            : std::make_pair(blkId, axiId);
+
+    uint32_t total;
+    std::vector<TDMResourceRequest> requests;
+    const auto amounts = getHWResourcePartition(tdmAttrId, name, blkId, axiId, displays,
+                                                reachMasks, requests, total);
+    for (size_t i = 0; i < displays.size(); i++) {
+        displays[i]->mDisplayTDMInfo[TDMInfoIdx].initTDMInfo(
+                DisplayTDMInfo::ResourceAmount_t{amounts[i]}, tdmAttrId);
+        HDEBUGLOGD(eDebugTDM, "(%s) : total=%d reserve=%d cap=%d %s amount is updated to %d",
+                   HWResourceIndexes(tdmAttrId, blkId, axiId, displays[i]->mType,
+                                     mConstraintRev)
+                           .toString8()
+                           .c_str(),
+                   total, requests[i].reserve, requests[i].cap, name.c_str(), amounts[i]);
+    }
+}
+
+void ExynosResourceManagerModule::checkHWResourcePartition(
+        const tdm_attr_t &tdmAttrId, const String8 &name, const DPUblockId_t &blkId,
+        const AXIPortId_t &axiId, const std::vector<ExynosDisplay *> &displays,
+        const std::vector<uint32_t> &reachMasks) {
+    const auto &TDMInfoIdx = (HWAttrs.at(tdmAttrId).loadSharing == LS_DPUF)
+            ? std::make_pair(blkId, AXI_DONT_CARE)
+            : std::make_pair(blkId, axiId);
+
+    uint32_t total;
+    std::vector<TDMResourceRequest> requests;
+    const auto amounts = getHWResourcePartition(tdmAttrId, name, blkId, axiId, displays,
+                                                reachMasks, requests, total);
+    for (size_t i = 0; i < displays.size(); i++) {
+        const uint32_t kept = displays[i]->mDisplayTDMInfo[TDMInfoIdx]
+                                      .getAvailableAmount(tdmAttrId)
+                                      .totalAmount;
+        if (kept == amounts[i]) continue;
+        ALOGE("(%s) : %s amount %d was kept but a full split gives %d",
+              HWResourceIndexes(tdmAttrId, blkId, axiId, displays[i]->mType, mConstraintRev)
+                      .toString8()
+                      .c_str(),
+              name.c_str(), kept, amounts[i]);
+        partitionHWResource(tdmAttrId, name, blkId, axiId, displays, reachMasks);
+        return;
+    }
+}
+
+uint32_t ExynosResourceManagerModule::getPreAssignDisplayBit(ExynosDisplay *display) {
+    switch (display->mType) {
+        case HWC_DISPLAY_PRIMARY:
+            return (display->mIndex == 0) ? HWC_DISPLAY_PRIMARY_BIT : HWC_DISPLAY_SECONDARY_BIT;
+        case HWC_DISPLAY_EXTERNAL:
+            return HWC_DISPLAY_EXTERNAL_BIT;
+        case HWC_DISPLAY_VIRTUAL:
+            return HWC_DISPLAY_VIRTUAL_BIT;
+        default:
+            return 0;
+    }
+}
+
+uint32_t ExynosResourceManagerModule::getTDMReachMask(uint32_t blockId, uint32_t axiId) {
+    if (blockId >= DPU_BLOCK_CNT) return 0;
+    if (axiId == AXI_DONT_CARE)
+        return ((1u << AXI_PORT_MAX_CNT) - 1) << (blockId * AXI_PORT_MAX_CNT);
+    if (axiId >= AXI_PORT_MAX_CNT) return 0;
+    return 1u << (blockId * AXI_PORT_MAX_CNT + axiId);
+}
+
+std::vector<uint32_t> ExynosResourceManagerModule::getTDMReachMasks(
+        const std::vector<ExynosDisplay *> &displays) {
+    const uint32_t allReach = (1u << (DPU_BLOCK_CNT * AXI_PORT_MAX_CNT)) - 1;
+    std::vector<uint32_t> reachMasks(displays.size(), allReach);
+    mTDMReachMasks.clear();
+    for (auto &reach : mTDMReachDump) reach.store(kNoTDMReach, std::memory_order_relaxed);
+    /* dumpsys reads the masks by display slot, mTDMReachMasks is only for this thread */
+    auto setReach = [&](ExynosDisplay *display, uint32_t reach) {
+        mTDMReachMasks[display] = reach;
+        const uint32_t slot = getTDMDisplaySlot(display);
+        if (slot < mTDMReachDump.size())
+            mTDMReachDump[slot].store(reach, std::memory_order_relaxed);
+    };
+    if (!mJointPlanning) {
+        for (size_t i = 0; i < displays.size(); i++) setReach(displays[i], allReach);
+        return reachMasks;
+    }
+
+    /* Channels pre-assigned to an enabled display are reserved for it */
+    uint32_t enabledBits = 0;
+    for (auto display : displays) {
+        if (display->isEnabled()) enabledBits |= getPreAssignDisplayBit(display);
+    }
+
+    for (size_t i = 0; i < displays.size(); i++) {
+        const uint32_t displayBit = getPreAssignDisplayBit(displays[i]);
+        uint32_t reach = 0;
+        for (auto mpp : mOtfMPPs) {
+            const uint32_t owners = mpp->mPreAssignDisplayInfo & enabledBits;
+            if (owners && !(owners & displayBit)) continue;
+            reach |= getTDMReachMask(mpp->getHWBlockId(), mpp->getAXIPortId());
         }
+        /* Don't starve a display the pre-assignment doesn't describe */
+        reachMasks[i] = reach ? reach : allReach;
+        setReach(displays[i], reachMasks[i]);
+        HDEBUGLOGD(eDebugTDM, "%s : %s reaches 0x%x", __func__,
+                   displays[i]->mDisplayName.c_str(), reachMasks[i]);
     }
+    return reachMasks;
+}
+
+uint32_t ExynosResourceManagerModule::getChangedTDMReach(
+        const std::unordered_map<ExynosDisplay *, uint32_t> &previousReach) {
+    const uint32_t allReach = (1u << (DPU_BLOCK_CNT * AXI_PORT_MAX_CNT)) - 1;
+    if (!mTDMPartitioned) return allReach;
+
+    auto getReach = [](const std::unordered_map<ExynosDisplay *, uint32_t> &reachMasks,
+                       ExynosDisplay *display) -> uint32_t {
+        const auto &reach = reachMasks.find(display);
+        return (reach != reachMasks.end()) ? reach->second : 0;
+    };
 
     /*
-     * Update Primary's resource amount. primary = total - loot(other display's HW resource)
-     * Other's aready defined at initDisplaysTDMInfo()
+     * The split of a resource depends on the table, which is the same for every split, and
+     * on each display's request, which is {0, 0} without reach and its table amounts or
+     * demand with it. Demands only change in splits of every resource, or when the display
+     * is enabled or disabled. The order of the displays only matters among the displays
+     * reaching the resource, and a display only moves in it when its own enabled state
+     * changes (the primary display goes first or last). So a resource is split again where
+     * a display that was enabled or disabled reaches, before or after the change, and where
+     * the reach of any display changed, e.g. channels reserved or freed by it, or a display
+     * falling back to every resource. A full split is checked against this under eDebugTDM.
      */
+    uint32_t changed = 0;
+    for (auto &display : mDisplays) {
+        const uint32_t before = getReach(previousReach, display);
+        const uint32_t after = getReach(mTDMReachMasks, display);
+        changed |= before ^ after;
+        const auto &state = mTDMEnabledDisplays.find(display);
+        if ((state != mTDMEnabledDisplays.end()) && (state->second == display->isEnabled()))
+            continue;
+        changed |= before | after;
+    }
+    return changed;
+}
+
+std::vector<ExynosDisplay *> ExynosResourceManagerModule::getTDMSplitDisplays() {
+    std::vector<ExynosDisplay *> displays;
     ExynosDisplay *primaryDisplay = getDisplay(getDisplayId(HWC_DISPLAY_PRIMARY, 0));
+    if (primaryDisplay != nullptr && primaryDisplay->isEnabled())
+        displays.push_back(primaryDisplay);
+    for (auto &display : mDisplays) {
+        if (display == primaryDisplay) continue;
+        if (display->isEnabled()) displays.push_back(display);
+    }
+    if (primaryDisplay != nullptr && !primaryDisplay->isEnabled())
+        displays.push_back(primaryDisplay);
+    return displays;
+}
+
+void ExynosResourceManagerModule::updateTDMDemand(ExynosDisplay *display) {
+    if (!mDemandSplit) return;
+    mTDMValidates++;
+
+    bool changed = false;
+    const uint32_t displaySlot = getTDMDisplaySlot(display);
+    const bool primary = (display->mType == HWC_DISPLAY_PRIMARY) && (display->mIndex == 0);
+    /* The primary display takes what the others leave, only its assigned amounts count */
+    if (!primary && (displaySlot < mTDMDemands.size())) {
+        TDMDemand &demand = mTDMDemands[displaySlot];
+        TDMAmounts stack;
+        getTDMStackDemand(display, stack);
+        changed = !demand.known || demand.idle ||
+                stack.greaterThan(demand.stack) || demand.stack.greaterThan(stack);
+        demand.known = true;
+        demand.idle = false;
+        demand.lastValidate = mTDMValidates;
+        demand.stack = stack;
+    }
+
+    /* A display that stopped validating keeps what it has on screen only */
+    for (uint32_t slot = 0; slot < mDisplays.size() && slot < mTDMDemands.size(); slot++) {
+        TDMDemand &demand = mTDMDemands[slot];
+        if (!demand.known || demand.idle || !mDisplays[slot]->isEnabled() ||
+            (mTDMValidates - demand.lastValidate <= kTDMIdleValidates))
+            continue;
+        demand.idle = true;
+        changed = true;
+    }
+
+    if (changed) splitTDMResourcesByDemand();
+}
+
+void ExynosResourceManagerModule::getTDMStackDemand(ExynosDisplay *display,
+                                                    TDMAmounts &demand) {
+    struct Window {
+        int32_t top;
+        int32_t bottom;
+        TDMAmounts amounts;
+    };
+    std::vector<Window> windows;
+    for (auto layer : display->mLayers) {
+        if (layer->mCompositionType == HWC2_COMPOSITION_CLIENT) continue;
+        /* Images of the previous validate can be stale, take the ones of this frame */
+        exynos_image src, dst;
+        layer->setSrcExynosImage(&src);
+        layer->setDstExynosImage(&dst);
+        Window window;
+        /* Full frame and the fixed margin, the channels and update region are not known */
+        getTDMWindowLines(static_cast<int32_t>(dst.y), static_cast<int32_t>(dst.h),
+                          TDM_OVERLAP_MARGIN, 0, static_cast<int32_t>(display->mYres),
+                          window.top, window.bottom);
+        std::array<uint32_t, TDM_ATTR_MAX> amounts{};
+        getHWResourceAmounts(display, src, dst, amounts);
+        for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++)
+            window.amounts[attr->first] = amounts[attr->first];
+        windows.push_back(window);
+    }
+
+    /* The busiest scanline is the top of one of the windows */
+    demand = TDMAmounts();
+    for (const auto &window : windows) {
+        TDMAmounts line;
+        for (const auto &other : windows) {
+            if ((other.top <= window.top) && (window.top <= other.bottom)) line += other.amounts;
+        }
+        demand = TDMAmounts::select(line.greaterThan(demand), line, demand);
+    }
+}
+
+void ExynosResourceManagerModule::getTDMAssignedPeak(ExynosDisplay *display, TDMBudget &peak) {
+    peak = TDMBudget();
+    buildTDMOccupancy(display);
+    auto addSource = [&](ExynosMPP *otfMPP, ExynosMPPSource *src) {
+        const uint32_t blockId = otfMPP->getHWBlockId();
+        if (blockId >= DPU_BLOCK_CNT) return;
+        int32_t top, bottom;
+        getTDMSpan(display, src->mSrcImg, src->mDstImg, top, bottom);
+        if (top > bottom) return;
+        for (uint32_t axiId = 0; axiId < AXI_PORT_MAX_CNT; axiId++) {
+            TDMAmounts DPUFAmounts;
+            TDMAmounts AXIAmounts;
+            if (!mTDMOccupancy.query(blockId, axiId, top, bottom, DPUFAmounts, AXIAmounts))
+                return;
+            const TDMAmounts line = TDMAmounts::select(mPerAXIAttrMask, AXIAmounts, DPUFAmounts);
+            TDMAmounts &amounts = peak.amounts[blockId][axiId];
+            amounts = TDMAmounts::select(line.greaterThan(amounts), line, amounts);
+        }
+    };
+
+    for (auto layer : display->mLayers) {
+        if (layer->mOtfMPP) addSource(layer->mOtfMPP, layer);
+    }
+    for (ExynosCompositionInfo *info :
+         {&display->mExynosCompositionInfo, &display->mClientCompositionInfo}) {
+        if (info->mHasCompositionLayer && info->mOtfMPP) addSource(info->mOtfMPP, info);
+    }
+}
+
+void ExynosResourceManagerModule::splitTDMResourcesByDemand() {
+    /* setDisplaysTDMInfo() does the first split, with the reach of the displays */
+    if (!mTDMPartitioned) return;
+    ATRACE_CALL();
+
+    mTDMBudgets.clear();
+    mTDMDecisions.clear();
+    mTDMRejections.clear();
+    /* What is on screen is taken in full, the update region is prepared again */
+    mTDMUpdateRegion.display = nullptr;
+    mTDMChecksPending = true;
+
+    const std::vector<ExynosDisplay *> displays = getTDMSplitDisplays();
+    std::vector<uint32_t> reachMasks(displays.size(), 0);
+    for (size_t i = 0; i < displays.size(); i++) {
+        const auto &reach = mTDMReachMasks.find(displays[i]);
+        if (reach != mTDMReachMasks.end()) reachMasks[i] = reach->second;
+        const uint32_t slot = getTDMDisplaySlot(displays[i]);
+        if (slot < mTDMDemands.size()) getTDMAssignedPeak(displays[i], mTDMDemands[slot].assigned);
+    }
+
     for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
         for (auto blockId = DPUBlocks.begin(); blockId != DPUBlocks.end(); blockId++) {
             if (attr->second.loadSharing == LS_DPUF) {
-                setupHWResource(attr->first, attr->second.name, blockId->first, AXI_DONT_CARE,
-                                primaryDisplay, addedDisplay, mConstraintRev);
+                partitionHWResource(attr->first, attr->second.name, blockId->first,
+                                    AXI_DONT_CARE, displays, reachMasks);
+                mTDMStats.budgetEntries.add();
             } else if (attr->second.loadSharing == LS_DPUF_AXI) {
                 for (auto axi = AXIPorts.begin(); axi != AXIPorts.end(); ++axi) {
-                    setupHWResource(attr->first, attr->second.name, blockId->first, axi->first,
-                                    primaryDisplay, addedDisplay, mConstraintRev);
+                    partitionHWResource(attr->first, attr->second.name, blockId->first,
+                                        axi->first, displays, reachMasks);
+                    mTDMStats.budgetEntries.add();
                 }
             }
         }
     }
+}
+
+uint32_t ExynosResourceManagerModule::setDisplaysTDMInfo()
+{
+    ATRACE_CALL();
+    TDMStatsScope statsScope(mTDMStats.budgetUpdate, mTDMCallStats);
+
+    /* needHWResource() can depend on display state, don't reuse amounts across changes */
+    mHWResourceAmountCache.clear();
+    mTDMBudgets.clear();
+    mTDMDecisions.clear();
+    mTDMRejections.clear();
+
+    /*
+     * Split every HW resource between the primary display and the enabled displays from
+     * the table, as one plan over both primary panels and the external display. The other
+     * enabled displays get what their layers need up to their maxAssignedAmount, see
+     * getHWResourcePartition(), the primary display comes first and takes what they leave,
+     * a disabled primary display comes last and only gets that leftover. The demands are
+     * updated at validates and everything is split again when one changes or a display goes
+     * idle, see updateTDMDemand().
+     * A display only gets amounts of the DPUFs and AXI ports it has channels on, so a panel
+     * turned on at fold/unfold takes over the channels of the other one without both
+     * holding budgets they cannot use.
+     * Disabled non-primary displays keep the amounts of initDisplaysTDMInfo(), they are not
+     * assigned until they are enabled and this is called again.
+     * Only the resources whose split can change are split again, see getChangedTDMReach().
+     */
+    const std::vector<ExynosDisplay *> displays = getTDMSplitDisplays();
+
+    /* A display enabled or disabled starts over from the table caps until it validates */
+    for (uint32_t slot = 0; slot < mDisplays.size() && slot < mTDMDemands.size(); slot++) {
+        const auto &state = mTDMEnabledDisplays.find(mDisplays[slot]);
+        if ((state == mTDMEnabledDisplays.end()) ||
+            (state->second != mDisplays[slot]->isEnabled()))
+            mTDMDemands[slot] = TDMDemand();
+    }
+
+    const auto previousReach = mTDMReachMasks;
+    std::vector<uint32_t> reachMasks = getTDMReachMasks(displays);
+    const uint32_t changedReach = getChangedTDMReach(previousReach);
+    statsScope.setIncremental(changedReach != (1u << (DPU_BLOCK_CNT * AXI_PORT_MAX_CNT)) - 1);
+
+    mTDMEnabledDisplays.clear();
+    for (auto &display : mDisplays) mTDMEnabledDisplays[display] = display->isEnabled();
+    mTDMPartitioned = true;
+
+    /* Entries that are not split again should be what a full split gives them */
+    const bool checkKept = hwcCheckDebugMessages(eDebugTDM);
+    auto split = [&](const tdm_attr_t &tdmAttrId, const String8 &name,
+                     const DPUblockId_t &blkId, const AXIPortId_t &axiId) {
+        if (!(changedReach & getTDMReachMask(blkId, axiId))) {
+            if (checkKept)
+                checkHWResourcePartition(tdmAttrId, name, blkId, axiId, displays, reachMasks);
+            return;
+        }
+        partitionHWResource(tdmAttrId, name, blkId, axiId, displays, reachMasks);
+        mTDMStats.budgetEntries.add();
+    };
+    for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
+        for (auto blockId = DPUBlocks.begin(); blockId != DPUBlocks.end(); blockId++) {
+            if (attr->second.loadSharing == LS_DPUF) {
+                split(attr->first, attr->second.name, blockId->first, AXI_DONT_CARE);
+            } else if (attr->second.loadSharing == LS_DPUF_AXI) {
+                for (auto axi = AXIPorts.begin(); axi != AXIPorts.end(); ++axi)
+                    split(attr->first, attr->second.name, blockId->first, axi->first);
+            }
+        }
+    }
 
     if (hwcCheckDebugMessages(eDebugTDM)) {
         for (auto &display : mDisplays) {
             for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
                 for (auto blockId = DPUBlocks.begin(); blockId != DPUBlocks.end(); blockId++) {
                     if (attr->second.loadSharing == LS_DPUF) {
+                        if (!(changedReach & getTDMReachMask(blockId->first, AXI_DONT_CARE)))
+                            continue;
                         const auto &TDMInfoId = std::make_pair(blockId->first, AXI_DONT_CARE);
                         int32_t amount = display->mDisplayTDMInfo[TDMInfoId]
                                                  .getAvailableAmount(attr->first)
@@ -235,6 +893,8 @@ uint32_t ExynosResourceManagerModule::setDisplaysTDMInfo()
                                    display->isEnabled() ? "used" : "not used");
                     } else {
                         for (auto axi = AXIPorts.begin(); axi != AXIPorts.end(); ++axi) {
+                            if (!(changedReach & getTDMReachMask(blockId->first, axi->first)))
+                                continue;
                             const auto &TDMInfoId = std::make_pair(blockId->first, axi->first);
                             int32_t amount = display->mDisplayTDMInfo[TDMInfoId]
                                                      .getAvailableAmount(attr->first)
@@ -258,18 +918,26 @@ uint32_t ExynosResourceManagerModule::initDisplaysTDMInfo()
 {
     /*
      * Initialize as predefined value at table
-     * Primary's resource will be changed at setDisplaysTDMInfo() function
+     * Enabled displays' resource will be split at setDisplaysTDMInfo() function
      */
+    ATRACE_CALL();
+    TDMStatsScope statsScope(mTDMStats.budgetInit, mTDMCallStats);
+
+    mTDMBudgets.clear();
+    mTDMDecisions.clear();
+    mTDMRejections.clear();
+    /* Every amount is back to the table, the next split covers all of them */
+    mTDMPartitioned = false;
     for (auto &display : mDisplays) {
         for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
             for (auto blockId = DPUBlocks.begin(); blockId != DPUBlocks.end(); blockId++) {
                 if (attr->second.loadSharing == LS_DPUF) {
                     setupHWResource(attr->first, attr->second.name, blockId->first, AXI_DONT_CARE,
-                                    display, nullptr, mConstraintRev);
+                                    display, mConstraintRev);
                 } else if (attr->second.loadSharing == LS_DPUF_AXI) {
                     for (auto axi = AXIPorts.begin(); axi != AXIPorts.end(); ++axi) {
                         setupHWResource(attr->first, attr->second.name, blockId->first, axi->first,
-                                        display, nullptr, mConstraintRev);
+                                        display, mConstraintRev);
                     }
                 }
             }
@@ -279,58 +947,26 @@ uint32_t ExynosResourceManagerModule::initDisplaysTDMInfo()
     return 0;
 }
 
-uint32_t getSramAmount(tdm_attr_t attr, uint32_t formatProperty, lbWidthIndex_t widthIndex) {
-    auto it = sramAmountMap.find(sramAmountParams(attr, formatProperty, widthIndex));
-    return (it != sramAmountMap.end()) ? it->second : 0;
-}
-
-uint32_t ExynosResourceManagerModule::calculateHWResourceAmount(ExynosDisplay *display,
-                                                                ExynosMPPSource *mppSrc)
-{
+uint32_t ExynosResourceManagerModule::getHWResourceAmounts(
+        ExynosDisplay *display, exynos_image &src, exynos_image &dst,
+        std::array<uint32_t, TDM_ATTR_MAX> &amounts) {
     uint32_t SRAMtotal = 0;
 
-    if (mppSrc == nullptr) return SRAMtotal;
-
-    if (mppSrc->mSourceType == MPP_SOURCE_LAYER) {
-        ExynosLayer *layer = static_cast<ExynosLayer *>(mppSrc->mSource);
-        if (layer == nullptr) {
-            ALOGE("%s: cannot cast ExynosLayer", __func__);
-            return SRAMtotal;
-        }
-        exynos_image src_img;
-        exynos_image dst_img;
-        layer->setSrcExynosImage(&src_img);
-        layer->setDstExynosImage(&dst_img);
-        layer->setExynosImage(src_img, dst_img);
-    }
-
-    int32_t transform = mppSrc->mSrcImg.transform;
-    int32_t compressType = mppSrc->mSrcImg.compressionInfo.type;
+    int32_t transform = src.transform;
+    int32_t compressType = src.compressionInfo.type;
     bool rotation = (transform & HAL_TRANSFORM_ROT_90) ? true : false;
 
-    int32_t width = mppSrc->mSrcImg.w;
-    int32_t height = mppSrc->mSrcImg.h;
-    uint32_t format = mppSrc->mSrcImg.format;
+    int32_t width = src.w;
+    int32_t height = src.h;
+    uint32_t format = src.format;
     uint32_t formatBPP = 0;
     if (isFormat10Bit(format))
         formatBPP = BIT10;
     else if (isFormat8Bit(format))
         formatBPP = BIT8;
 
-    /** To find index **/
-    uint32_t formatIndex = 0;
-
     lbWidthIndex_t widthIndex = LB_W_3073_INF;
 
-    auto findWidthIndex = [&](int32_t w) -> lbWidthIndex_t {
-        for (auto it = LB_WIDTH_INDEX_MAP.begin(); it != LB_WIDTH_INDEX_MAP.end(); it++) {
-            if (w >= it->second.widthDownto && w <= it->second.widthUpto) {
-                return it->first;
-            }
-        }
-        return LB_W_3073_INF;
-    };
-
     /* Caluclate SRAM amount */
     if (rotation) {
         width = height;
@@ -340,13 +976,19 @@ uint32_t ExynosResourceManagerModule::calculateHWResourceAmount(ExynosDisplay *d
             int32_t width_y = pixel_align(width + kSramSBWCRotWidthAlign, kSramSBWCRotWidthAlign);
             int32_t width_c =
                     pixel_align(width / 2 + kSramSBWCRotWidthAlign, kSramSBWCRotWidthAlign);
-            SRAMtotal += getSramAmount(TDM_ATTR_ROT_90, SBWC_Y, findWidthIndex(width_y));
-            SRAMtotal += getSramAmount(TDM_ATTR_ROT_90, SBWC_UV, findWidthIndex(width_c * 2));
+            SRAMtotal += getSramAmount(SRAM_ROT_SBWC_Y, getLbWidthIndex(width_y));
+            SRAMtotal += getSramAmount(SRAM_ROT_SBWC_UV, getLbWidthIndex(width_c * 2));
         } else {
-            /* sramAmountMap has SRAM for both Y and UV */
-            widthIndex = findWidthIndex(width);
-            SRAMtotal += getSramAmount(TDM_ATTR_ROT_90, NON_SBWC_Y | formatBPP, widthIndex);
-            SRAMtotal += getSramAmount(TDM_ATTR_ROT_90, NON_SBWC_UV | formatBPP, widthIndex);
+            /* SRAM_AMOUNT_TABLE has SRAM for both Y and UV */
+            widthIndex = getLbWidthIndex(width);
+            SRAMtotal += getSramAmount((formatBPP == BIT10) ? SRAM_ROT_Y_10BIT
+                                               : (formatBPP == BIT8) ? SRAM_ROT_Y_8BIT
+                                                                     : SRAM_ROW_NONE,
+                                       widthIndex);
+            SRAMtotal += getSramAmount((formatBPP == BIT10) ? SRAM_ROT_UV_10BIT
+                                               : (formatBPP == BIT8) ? SRAM_ROT_UV_8BIT
+                                                                     : SRAM_ROW_NONE,
+                                       widthIndex);
         }
         HDEBUGLOGD(eDebugTDM, "+ rotation : %d", SRAMtotal);
     } else {
@@ -361,19 +1003,25 @@ uint32_t ExynosResourceManagerModule::calculateHWResourceAmount(ExynosDisplay *d
                 width = pixel_align(width + kSramAFBC2BMargin, kSramAFBC2BAlign);
             }
         }
-        widthIndex = findWidthIndex(width);
+        widthIndex = getLbWidthIndex(width);
 
-        /* AFBC amount */
+        /* AFBC amount, only RGB formats need SRAM */
         if (compressType == COMP_TYPE_AFBC) {
-            formatIndex = (isFormatRgb(format) ? RGB : 0) | formatBPP;
-            SRAMtotal += getSramAmount(TDM_ATTR_AFBC, formatIndex, widthIndex);
+            sramAmountRow_t row = SRAM_ROW_NONE;
+            if (isFormatRgb(format)) {
+                if (formatBPP == BIT8)
+                    row = SRAM_AFBC_RGB_32BIT;
+                else if (formatBPP == 0)
+                    row = SRAM_AFBC_RGB_16BIT;
+            }
+            SRAMtotal += getSramAmount(row, widthIndex);
             HDEBUGLOGD(eDebugTDM, "+ AFBC : %d", SRAMtotal);
         }
 
         /* SBWC amount */
         if (compressType == COMP_TYPE_SBWC) {
-            SRAMtotal += getSramAmount(TDM_ATTR_SBWC, SBWC_Y, widthIndex);
-            SRAMtotal += getSramAmount(TDM_ATTR_SBWC, SBWC_UV, widthIndex);
+            SRAMtotal += getSramAmount(SRAM_SBWC_Y, widthIndex);
+            SRAMtotal += getSramAmount(SRAM_SBWC_UV, widthIndex);
             HDEBUGLOGD(eDebugTDM, "+ SBWC : %d", SRAMtotal);
         }
     }
@@ -381,15 +1029,18 @@ uint32_t ExynosResourceManagerModule::calculateHWResourceAmount(ExynosDisplay *d
     /* ITP (CSC) amount */
     if (isFormatYUV(format)) {
         /** ITP has no size difference, Use width index as LB_W_3073_INF **/
-        SRAMtotal += getSramAmount(TDM_ATTR_ITP, formatBPP, LB_W_3073_INF);
+        SRAMtotal += getSramAmount((formatBPP == BIT10) ? SRAM_ITP_10BIT
+                                           : (formatBPP == BIT8) ? SRAM_ITP_8BIT
+                                                                 : SRAM_ROW_NONE,
+                                   LB_W_3073_INF);
         HDEBUGLOGD(eDebugTDM, "+ YUV : %d", SRAMtotal);
     }
 
     /* Scale amount */
-    int srcW = mppSrc->mSrcImg.w;
-    int srcH = mppSrc->mSrcImg.h;
-    int dstW = mppSrc->mDstImg.w;
-    int dstH = mppSrc->mDstImg.h;
+    int srcW = src.w;
+    int srcH = src.h;
+    int dstW = dst.w;
+    int dstH = dst.h;
 
     if (!!(transform & HAL_TRANSFORM_ROT_90)) {
         int tmp = dstW;
@@ -400,45 +1051,196 @@ uint32_t ExynosResourceManagerModule::calculateHWResourceAmount(ExynosDisplay *d
     bool isScaled = ((srcW != dstW) || (srcH != dstH));
 
     if (isScaled) {
-        if (formatHasAlphaChannel(format))
-            formatIndex = FORMAT_RGB_MASK;
-        else
-            formatIndex = FORMAT_YUV_MASK;
+        const sramAmountRow_t row =
+                formatHasAlphaChannel(format) ? SRAM_SCALE_ALPHA : SRAM_SCALE_NO_ALPHA;
 
         /** Scale has no size difference, Use width index as LB_W_3073_INF **/
-        SRAMtotal += getSramAmount(TDM_ATTR_SCALE, formatIndex, LB_W_3073_INF);
+        SRAMtotal += getSramAmount(row, LB_W_3073_INF);
         HDEBUGLOGD(eDebugTDM, "+ Scale : %d", SRAMtotal);
     }
 
     for (auto it = HWAttrs.begin(); it != HWAttrs.end(); it++) {
-        uint32_t amount = 0;
         if (it->first == TDM_ATTR_SRAM_AMOUNT) {
-            amount = SRAMtotal;
+            amounts[it->first] = SRAMtotal;
         } else {
-            amount = needHWResource(display, mppSrc->mSrcImg, mppSrc->mDstImg, it->first);
+            amounts[it->first] = needHWResource(display, src, dst, it->first);
         }
-        mppSrc->setHWResourceAmount(it->first, amount);
     }
 
+    return SRAMtotal;
+}
+
+uint32_t ExynosResourceManagerModule::calculateHWResourceAmount(ExynosDisplay *display,
+                                                                ExynosMPPSource *mppSrc)
+{
+    uint32_t SRAMtotal = 0;
+
+    if (mppSrc == nullptr) return SRAMtotal;
+
+    if (mppSrc->mSourceType == MPP_SOURCE_LAYER) {
+        ExynosLayer *layer = static_cast<ExynosLayer *>(mppSrc->mSource);
+        if (layer == nullptr) {
+            ALOGE("%s: cannot cast ExynosLayer", __func__);
+            return SRAMtotal;
+        }
+        exynos_image src_img;
+        exynos_image dst_img;
+        layer->setSrcExynosImage(&src_img);
+        layer->setDstExynosImage(&dst_img);
+        layer->setExynosImage(src_img, dst_img);
+    }
+
+    /* Most sources keep their format and geometry across frames */
+    const HWResourceAmountKey key = getHWResourceAmountKey(display, mppSrc);
+    const auto &cached = mHWResourceAmountCache.find(mppSrc);
+    if ((cached != mHWResourceAmountCache.end()) && (cached->second.key == key)) {
+        for (auto it = HWAttrs.begin(); it != HWAttrs.end(); it++)
+            mppSrc->setHWResourceAmount(it->first, cached->second.amounts[it->first]);
+        return cached->second.amounts[TDM_ATTR_SRAM_AMOUNT];
+    }
+
+    HWResourceAmountCache entry{key, {}};
+    SRAMtotal = getHWResourceAmounts(display, mppSrc->mSrcImg, mppSrc->mDstImg, entry.amounts);
+    for (auto it = HWAttrs.begin(); it != HWAttrs.end(); it++)
+        mppSrc->setHWResourceAmount(it->first, entry.amounts[it->first]);
+
     HDEBUGLOGD(eDebugTDM,
                "mppSrc(%p) needed SRAM(%d), SCALE(%d), AFBC(%d), CSC(%d), SBWC(%d), WCG(%d), "
                "ROT(%d)",
-               mppSrc->mSrcImg.bufferHandle, SRAMtotal,
-               needHWResource(display, mppSrc->mSrcImg, mppSrc->mDstImg, TDM_ATTR_SCALE),
-               needHWResource(display, mppSrc->mSrcImg, mppSrc->mDstImg, TDM_ATTR_AFBC),
-               needHWResource(display, mppSrc->mSrcImg, mppSrc->mDstImg, TDM_ATTR_ITP),
-               needHWResource(display, mppSrc->mSrcImg, mppSrc->mDstImg, TDM_ATTR_SBWC),
-               needHWResource(display, mppSrc->mSrcImg, mppSrc->mDstImg, TDM_ATTR_WCG),
-               needHWResource(display, mppSrc->mSrcImg, mppSrc->mDstImg, TDM_ATTR_ROT_90));
+               mppSrc->mSrcImg.bufferHandle, SRAMtotal, entry.amounts[TDM_ATTR_SCALE],
+               entry.amounts[TDM_ATTR_AFBC], entry.amounts[TDM_ATTR_ITP],
+               entry.amounts[TDM_ATTR_SBWC], entry.amounts[TDM_ATTR_WCG],
+               entry.amounts[TDM_ATTR_ROT_90]);
+
+    /* Sources are not removed from the cache when they are destroyed, bound it instead */
+    if (mHWResourceAmountCache.size() >= kMaxHWResourceAmountCacheSize)
+        mHWResourceAmountCache.clear();
+    mHWResourceAmountCache[mppSrc] = entry;
 
     return SRAMtotal;
 }
 
+ExynosResourceManagerModule::HWResourceAmountKey
+ExynosResourceManagerModule::getHWResourceAmountKey(ExynosDisplay *display,
+                                                    ExynosMPPSource *mppSrc) {
+    const exynos_image &src = mppSrc->mSrcImg;
+    const exynos_image &dst = mppSrc->mDstImg;
+    return HWResourceAmountKey{display,
+                               src.format,
+                               src.w,
+                               src.h,
+                               src.transform,
+                               src.compressionInfo.type,
+                               src.dataSpace,
+                               dst.w,
+                               dst.h,
+                               dst.dataSpace};
+}
+
+void ExynosResourceManagerModule::buildOtfChannelMasks() {
+    mOtfChannels.clear();
+    mOtfFormatMasks.clear();
+    for (auto &mask : mOtfAttrMasks) mask = 0;
+    for (auto &mask : mOtfPreAssignMasks) mask = 0;
+    if (mOtfMPPs.size() > kMaxOtfChannels) return;
+
+    for (auto mpp : mOtfMPPs) {
+        const uint32_t bit = 1u << mOtfChannels.size();
+        mOtfChannels.push_back(mpp);
+        const uint64_t attr = mpp->mAttr;
+        for (uint32_t i = 0; i < kMaxAttrBits; i++) {
+            if ((attr >> i) & 1) mOtfAttrMasks[i] |= bit;
+            if ((mpp->mPreAssignDisplayInfo >> i) & 1) mOtfPreAssignMasks[i] |= bit;
+        }
+        for (uint32_t i = 0; i < mFormatRestrictionCnt; i++) {
+            if (mFormatRestrictions[i].hwType == mpp->mPhysicalType)
+                mOtfFormatMasks[mFormatRestrictions[i].format] |= bit;
+        }
+    }
+}
+
+uint32_t ExynosResourceManagerModule::getOtfCandidateMask(ExynosDisplay *display,
+                                                          const exynos_image &src,
+                                                          const exynos_image &dst) {
+    if (mOtfChannels.size() != mOtfMPPs.size()) buildOtfChannelMasks();
+    if (mOtfChannels.empty()) return kAllOtfCandidates;
+
+    uint32_t mask = (mOtfChannels.size() < kMaxOtfChannels)
+            ? (1u << mOtfChannels.size()) - 1
+            : kAllOtfCandidates;
+
+    /* Formats the table has no entry for are not restricted */
+    const auto &formatMask = mOtfFormatMasks.find(src.format);
+    if (formatMask != mOtfFormatMasks.end()) mask &= formatMask->second;
+
+    uint64_t attr = 0;
+    if (src.compressionInfo.type == COMP_TYPE_AFBC) attr |= MPP_ATTR_AFBC;
+    if (src.transform & HAL_TRANSFORM_ROT_90) attr |= MPP_ATTR_ROT_90;
+    if (src.transform & HAL_TRANSFORM_FLIP_H) attr |= MPP_ATTR_FLIP_H;
+    if (src.transform & HAL_TRANSFORM_FLIP_V) attr |= MPP_ATTR_FLIP_V;
+    const bool rot90 = !!(src.transform & HAL_TRANSFORM_ROT_90);
+    if ((src.w != (rot90 ? dst.h : dst.w)) || (src.h != (rot90 ? dst.w : dst.h)))
+        attr |= MPP_ATTR_SCALE;
+    while (attr) {
+        const uint32_t i = __builtin_ctzll(attr);
+        if (i < kMaxAttrBits) mask &= mOtfAttrMasks[i];
+        attr &= attr - 1;
+    }
+
+    /* Channels pre-assigned only to other enabled displays are reserved for them */
+    const uint32_t displayBit = getPreAssignDisplayBit(display);
+    uint32_t reserved = 0;
+    for (auto &other : mDisplays) {
+        if ((other == display) || !other->isEnabled()) continue;
+        const uint32_t otherBit = getPreAssignDisplayBit(other);
+        if (otherBit) reserved |= mOtfPreAssignMasks[__builtin_ctz(otherBit)];
+    }
+    if (displayBit) reserved &= ~mOtfPreAssignMasks[__builtin_ctz(displayBit)];
+
+    return mask & ~reserved;
+}
+
+uint32_t ExynosResourceManagerModule::getOtfChannelBit(ExynosMPP *mpp) const {
+    const auto &channel = std::find(mOtfChannels.begin(), mOtfChannels.end(), mpp);
+    if (channel == mOtfChannels.end()) return 0;
+    return 1u << (channel - mOtfChannels.begin());
+}
+
+bool ExynosResourceManagerModule::isOtfCandidate(uint32_t candidates, ExynosMPP *mpp) const {
+    const uint32_t bit = getOtfChannelBit(mpp);
+    return (bit == 0) || (candidates & bit);
+}
+
+bool ExynosResourceManagerModule::isFilteredOtfCandidate(ExynosDisplay *display,
+                                                         ExynosMPP *currentMPP,
+                                                         ExynosMPPSource *mppSrc) {
+    /* Only layers given to the otf MPP as they are, m2m output is checked as it is */
+    if (!mFilterOtfCandidates || (mppSrc->mSourceType != MPP_SOURCE_LAYER) ||
+        (mppSrc->mM2mMPP != nullptr))
+        return false;
+    /* Re-checks of channels with layers already on them are not filtered */
+    if ((currentMPP->mAssignedState & MPP_ASSIGN_STATE_ASSIGNED) ||
+        (mppSrc->mOtfMPP == currentMPP))
+        return false;
+
+    if ((mOtfCandidates.display != display) || (mOtfCandidates.source != mppSrc)) {
+        mOtfCandidates = {display, mppSrc,
+                          getOtfCandidateMask(display, mppSrc->mSrcImg, mppSrc->mDstImg)};
+    }
+    return !isOtfCandidate(mOtfCandidates.mask, currentMPP);
+}
+
 int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay *display,
                                                       ExynosMPPVector &otfMPPs,
                                                       struct exynos_image &src,
                                                       struct exynos_image &dst)
 {
+    TDMStatsScope statsScope(mTDMStats.reordering, mTDMCallStats);
+
+    const bool packing = isPacking(display);
+    (packing ? mTDMStats.packedReorderings : mTDMStats.spreadReorderings).add();
+    ATRACE_INT("TDM packing", packing);
+
     int orderingType = isAFBCCompressed(src.bufferHandle)
             ? ORDER_AFBC
             : (needHdrProcessing(display, src, dst) ? ORDER_WCG : ORDER_AXI);
@@ -447,6 +1249,8 @@ int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay *display,
     int usedWCGCount[DPU_BLOCK_CNT * AXI_PORT_MAX_CNT] = {0};
     int usedBlockCount[DPU_BLOCK_CNT] = {0};
     int usedAXIPortCount[AXI_PORT_MAX_CNT] = {0};
+    uint64_t usedBlockBandwidth[DPU_BLOCK_CNT] = {0};
+    uint64_t usedAXIPortBandwidth[AXI_PORT_MAX_CNT] = {0};
 
     auto orderPolicy = [&](const void *lhs, const void *rhs) -> bool {
         if (lhs == NULL || rhs == NULL) {
@@ -461,6 +1265,10 @@ int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay *display,
 
         if (assignedStateL != assignedStateR) return assignedStateL < assignedStateR;
 
+        /* Fill PACKING_BLOCK first, the others are tried when its budgets are used up */
+        if (packing && ((l->mHWBlockId == PACKING_BLOCK) != (r->mHWBlockId == PACKING_BLOCK)))
+            return l->mHWBlockId == PACKING_BLOCK;
+
         if (l->mPhysicalType != r->mPhysicalType) return l->mPhysicalType < r->mPhysicalType;
 
         if (orderingType == ORDER_AFBC) {
@@ -489,10 +1297,14 @@ int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay *display,
 
         /* AXI bus balancing */
         /* AXI port which has not been used much should be placed in the front */
+        if (usedAXIPortBandwidth[l->mAXIPortId] != usedAXIPortBandwidth[r->mAXIPortId])
+            return usedAXIPortBandwidth[l->mAXIPortId] < usedAXIPortBandwidth[r->mAXIPortId];
         if (usedAXIPortCount[l->mAXIPortId] != usedAXIPortCount[r->mAXIPortId]) {
             return usedAXIPortCount[l->mAXIPortId] < usedAXIPortCount[r->mAXIPortId];
         }
         /* IF MPP connected same AXI port, Block balancing should be regarded after */
+        if (usedBlockBandwidth[l->mHWBlockId] != usedBlockBandwidth[r->mHWBlockId])
+            return usedBlockBandwidth[l->mHWBlockId] < usedBlockBandwidth[r->mHWBlockId];
         if (usedBlockCount[l->mHWBlockId] != usedBlockCount[r->mHWBlockId])
             return usedBlockCount[l->mHWBlockId] < usedBlockCount[r->mHWBlockId];
 
@@ -540,6 +1352,14 @@ int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay *display,
                        (mppSrc->mSourceType == MPP_SOURCE_LAYER) ? "Layer" : "Client Target");
             usedBlockCount[bId]++;
             usedAXIPortCount[aId]++;
+            if (mBandwidthBalancing) {
+                ExynosDisplay *srcDisplay =
+                        mpp->mAssignedDisplay ? mpp->mAssignedDisplay : display;
+                const uint64_t bandwidth =
+                        getReadBandwidth(srcDisplay, mppSrc->mSrcImg, mppSrc->mDstImg);
+                usedBlockBandwidth[bId] += bandwidth;
+                usedAXIPortBandwidth[aId] += bandwidth;
+            }
         }
     }
 
@@ -549,8 +1369,32 @@ int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay *display,
                (orderingType == ORDER_AFBC) ? "AFBC" : "_AXI", usedAFBCCount[DPUF0],
                usedAFBCCount[DPUF1], usedAXIPortCount[AXI0], usedAXIPortCount[AXI1],
                usedBlockCount[DPUF0], usedBlockCount[DPUF1]);
+    HDEBUGLOGD(eDebugLoadBalancing,
+               "Read bandwidth(KB/s) AXI0:%" PRIu64 ", AXI1:%" PRIu64 ", DPUF0:%" PRIu64
+               ", DPUF1:%" PRIu64,
+               usedAXIPortBandwidth[AXI0] / 1024, usedAXIPortBandwidth[AXI1] / 1024,
+               usedBlockBandwidth[DPUF0] / 1024, usedBlockBandwidth[DPUF1] / 1024);
 
-    std::sort(otfMPPs.begin(), otfMPPs.end(), orderPolicy);
+    /*
+     * Channels that cannot take the layer go last in their current order, only the others
+     * are sorted. Assigned channels are not candidates but are still kept for the TDM check
+     * of the layers already on them.
+     */
+    auto sortEnd = otfMPPs.end();
+    if (mFilterOtfCandidates) {
+        const uint32_t candidates = getOtfCandidateMask(display, src, dst);
+        sortEnd = std::stable_partition(otfMPPs.begin(), otfMPPs.end(), [&](ExynosMPP *mpp) {
+            return isOtfCandidate(candidates, mpp) &&
+                    !(mpp->mAssignedState & MPP_ASSIGN_STATE_ASSIGNED);
+        });
+    }
+    std::sort(otfMPPs.begin(), sortEnd, orderPolicy);
+
+    /* The solver spreads layers to keep the most of them on DPP */
+    if (mOptimalOtfAssign && !packing) {
+        prepareTDMChecks(display);
+        reorderOtfMppsBySolver(display, otfMPPs, src, dst);
+    }
 
     if (hwcCheckDebugMessages(eDebugLoadBalancing)) {
         String8 after;
@@ -565,17 +1409,117 @@ int32_t ExynosResourceManagerModule::otfMppReordering(ExynosDisplay *display,
     return 0;
 }
 
+void ExynosResourceManagerModule::setPackingPolicy(packingPolicy_t policy) {
+    if (static_cast<uint32_t>(policy) >= PACKING_POLICY_CNT) {
+        ALOGW("%s: unknown policy %d, spread layers", __func__, policy);
+        policy = PACKING_SPREAD;
+    }
+    mPackingPolicy.store(policy, std::memory_order_relaxed);
+}
+
+bool ExynosResourceManagerModule::isPacking(ExynosDisplay *display) const {
+    switch (mPackingPolicy.load(std::memory_order_relaxed)) {
+        case PACKING_ALWAYS:
+            return true;
+        case PACKING_LIGHT_LOAD:
+            /* Spread again once the stack needs the bandwidth of both DPUFs */
+            return display->mLayers.size() <= static_cast<size_t>(mPackingMaxLayers);
+        default:
+            return false;
+    }
+}
+
+uint64_t ExynosResourceManagerModule::getReadBandwidth(ExynosDisplay *display,
+                                                      const exynos_image &src,
+                                                      const exynos_image &dst) {
+    const uint32_t format = src.format;
+    uint64_t bitsPerPixel = 32;
+    if (isFormatYUV(format))
+        bitsPerPixel = isFormat10Bit(format) ? 24 : 12;
+    else if (format == HAL_PIXEL_FORMAT_RGB_565)
+        bitsPerPixel = 16;
+    else if (format == HAL_PIXEL_FORMAT_RGBA_FP16)
+        bitsPerPixel = 64;
+
+    uint64_t bytes = static_cast<uint64_t>(src.w) * src.h * bitsPerPixel / 8;
+    if (src.compressionInfo.type == COMP_TYPE_AFBC)
+        bytes = bytes * kAFBCReadPercent / 100;
+    else if (src.compressionInfo.type == COMP_TYPE_SBWC)
+        bytes = bytes * kSBWCReadPercent / 100;
+
+    int32_t refreshRate = display->getRefreshRate(display->mActiveConfig);
+    if (refreshRate <= 0) refreshRate = kDefaultRefreshRate;
+
+    /* The source is read while its destination lines are scanned out */
+    const uint64_t yres = (display->mYres > 0) ? display->mYres : 1;
+    const uint64_t dstH = (dst.h > 0) ? std::min<uint64_t>(dst.h, yres) : yres;
+    return bytes * refreshRate * yres / dstH;
+}
+
+void ExynosResourceManagerModule::getTDMWindow(ExynosDisplay *display, const exynos_image &src,
+                                               const exynos_image &dst, bool current,
+                                               int32_t &top, int32_t &bottom) const {
+    uint32_t topMargin, bottomMargin;
+    if (mFixedOverlapMargin) {
+        /* Only the source being checked is padded, in both directions */
+        topMargin = bottomMargin = current ? TDM_OVERLAP_MARGIN : 0;
+    } else {
+        /* Source lines are fetched ahead of the destination lines, see getTDMWindowLines() */
+        const bool rot90 = !!(src.transform & HAL_TRANSFORM_ROT_90);
+        topMargin = getTDMFetchMargin(rot90 ? src.w : src.h, dst.h, rot90,
+                                      src.compressionInfo.type == COMP_TYPE_AFBC,
+                                      src.compressionInfo.type == COMP_TYPE_SBWC);
+        bottomMargin = 0;
+    }
+
+    getTDMWindowLines(static_cast<int32_t>(dst.y), static_cast<int32_t>(dst.h), topMargin,
+                      bottomMargin, static_cast<int32_t>(display->mYres), top, bottom);
+
+    /* Lines outside the update region are not scanned out, the window can become empty */
+    if (mTDMUpdateRegion.display == display) {
+        top = std::max(top, mTDMUpdateRegion.top);
+        bottom = std::min(bottom, mTDMUpdateRegion.bottom);
+    }
+}
+
+void ExynosResourceManagerModule::updateTDMUpdateRegion(ExynosDisplay *display) {
+    mTDMUpdateRegion.display = nullptr;
+    /* Only the region a commit was delivered with is final, see onTDMPresent() */
+    if (!mPartialUpdateTDM || !display->mDpuData.enable_win_update) return;
+
+    const auto &region = display->mDpuData.win_update_region;
+    const int32_t top = std::max(region.y, 0);
+    const int32_t bottom = static_cast<int32_t>(
+            std::min<int64_t>(static_cast<int64_t>(region.y) + region.h, display->mYres));
+    if ((top >= bottom) || ((top == 0) && (bottom == static_cast<int32_t>(display->mYres))))
+        return;
+
+    mTDMUpdateRegion = {display, top, bottom};
+    mTDMStats.partialUpdatePresents.add();
+}
+
+void ExynosResourceManagerModule::getTDMSpan(ExynosDisplay *display, const exynos_image &src,
+                                             const exynos_image &dst, int32_t &top,
+                                             int32_t &bottom) const {
+    getTDMWindow(display, src, dst, true, top, bottom);
+}
+
+void ExynosResourceManagerModule::getTDMExtent(ExynosDisplay *display, const exynos_image &src,
+                                               const exynos_image &dst, int32_t &top,
+                                               int32_t &bottom) const {
+    getTDMWindow(display, src, dst, false, top, bottom);
+}
+
 bool ExynosResourceManagerModule::isOverlapped(ExynosDisplay *display, ExynosMPPSource *current,
                                                ExynosMPPSource *compare) {
-    int CT = current->mDstImg.y - TDM_OVERLAP_MARGIN;
-    CT = (CT < 0) ? 0 : CT;
-    int CB = current->mDstImg.y + current->mDstImg.h + TDM_OVERLAP_MARGIN;
-    CB = (CB > display->mYres) ? display->mYres : CB;
-    int LT = compare->mDstImg.y;
-    int LB = compare->mDstImg.y + compare->mDstImg.h;
-
-    if (((LT <= CT && CT <= LB) || (LT <= CB && CB <= LB)) ||
-        ((CT <= LT && LT <= CB) || (CT < LB && LB <= CB))) {
+    int CT, CB;
+    getTDMSpan(display, current->mSrcImg, current->mDstImg, CT, CB);
+    int LT, LB;
+    getTDMExtent(display, compare->mSrcImg, compare->mDstImg, LT, LB);
+    /* Either source is outside the update region */
+    if ((CT > CB) || (LT > LB)) return false;
+
+    if (isTDMWindowOverlapped(CT, CB, LT, LB)) {
         HDEBUGLOGD(eDebugTDM, "%s, current %p and compare %p is overlaped", __func__,
                    current->mSrcImg.bufferHandle, compare->mSrcImg.bufferHandle);
         return true;
@@ -587,31 +1531,434 @@ bool ExynosResourceManagerModule::isOverlapped(ExynosDisplay *display, ExynosMPP
 uint32_t ExynosResourceManagerModule::getAmounts(ExynosDisplay* display, uint32_t currentBlockId,
                                                  uint32_t currentAXIId, ExynosMPP* compOtfMPP,
                                                  ExynosMPPSource* curSrc, ExynosMPPSource* compSrc,
-                                                 std::array<uint32_t, TDM_ATTR_MAX>& DPUFAmounts,
-                                                 std::array<uint32_t, TDM_ATTR_MAX>& AXIAmounts) {
+                                                 TDMAmounts& DPUFAmounts,
+                                                 TDMAmounts& AXIAmounts) {
     const uint32_t blockId = compOtfMPP->getHWBlockId();
     const uint32_t AXIId = compOtfMPP->getAXIPortId();
     if (currentBlockId == blockId && isOverlapped(display, curSrc, compSrc)) {
+        /* Rejections are kept in mTDMRejectionLog, this breakdown is for eDebugTDM only */
+        const bool debug = hwcCheckDebugMessages(eDebugTDM);
         String8 log;
-        if (hwcCheckDebugMessages(eDebugTDM)) {
-            log.appendFormat("%s", compOtfMPP->mName.c_str());
-        }
+        if (debug) log.appendFormat("%s", compOtfMPP->mName.c_str());
         for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
             uint32_t compareAmount = compSrc->getHWResourceAmount(attr->first);
-            if (hwcCheckDebugMessages(eDebugTDM)) {
+            if (debug) {
                 log.appendFormat(", attr %s DPUF-%d(+ %d)", attr->second.name.c_str(),
                                  DPUFAmounts[attr->first], compareAmount);
             }
             DPUFAmounts[attr->first] += compareAmount;
             if (attr->second.loadSharing == LS_DPUF_AXI && currentAXIId == AXIId) {
-                if (hwcCheckDebugMessages(eDebugTDM)) {
+                if (debug) {
                     log.appendFormat(",AXI-%d(+ %d)", AXIAmounts[attr->first], compareAmount);
                 }
                 AXIAmounts[attr->first] += compareAmount;
             }
         }
-        HDEBUGLOGD(eDebugTDM, "%s %s", __func__, log.c_str());
+        if (debug) HDEBUGLOGD(eDebugTDM, "%s %s", __func__, log.c_str());
     }
 
     return 0;
 }
+
+void ExynosResourceManagerModule::buildTDMOccupancy(ExynosDisplay *display) {
+    mTDMOccupancy.clear();
+    for (auto &state : mTDMBlockStates) state.clear();
+
+    auto addSource = [&](ExynosMPP *otfMPP, ExynosMPPSource *src, ExynosLayer *layer) {
+        int32_t top, bottom;
+        getTDMExtent(display, src->mSrcImg, src->mDstImg, top, bottom);
+        /* Outside the update region, it takes no line time in this frame */
+        if (top > bottom) return;
+        const TDMAmounts amounts = getTDMAmounts(src);
+        const uint32_t blockId = otfMPP->getHWBlockId();
+        const uint32_t axiId = otfMPP->getAXIPortId();
+        const size_t index = mTDMOccupancy.size();
+        if (!mTDMOccupancy.add(blockId, axiId, top, bottom, amounts)) return;
+        mTDMOccupancyLayers[index] = layer;
+
+        auto &state = mTDMBlockStates[blockId];
+        state.push_back(reinterpret_cast<uintptr_t>(src));
+        state.push_back((static_cast<uint64_t>(axiId) << 32) | static_cast<uint32_t>(top));
+        state.push_back(static_cast<uint32_t>(bottom));
+        for (size_t lane = 0; lane < TDMAmounts::kLanes; lane += 2)
+            state.push_back((static_cast<uint64_t>(amounts[lane]) << 32) | amounts[lane + 1]);
+    };
+
+    for (auto layer : display->mLayers) {
+        if (layer->mOtfMPP) addSource(layer->mOtfMPP, layer, layer);
+    }
+    if (display->mExynosCompositionInfo.mHasCompositionLayer &&
+        display->mExynosCompositionInfo.mOtfMPP)
+        addSource(display->mExynosCompositionInfo.mOtfMPP, &display->mExynosCompositionInfo,
+                  nullptr);
+    if (display->mClientCompositionInfo.mHasCompositionLayer &&
+        display->mClientCompositionInfo.mOtfMPP)
+        addSource(display->mClientCompositionInfo.mOtfMPP, &display->mClientCompositionInfo,
+                  nullptr);
+    mTDMOccupancy.build();
+}
+
+TDMAmounts ExynosResourceManagerModule::getTDMAmounts(ExynosMPPSource *mppSrc) const {
+    TDMAmounts amounts;
+    for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++)
+        amounts[attr->first] = mppSrc->getHWResourceAmount(attr->first);
+    return amounts;
+}
+
+const TDMAmounts &ExynosResourceManagerModule::getTDMBudget(ExynosDisplay *display,
+                                                            uint32_t blockId, uint32_t axiId) {
+    static const TDMAmounts kNoBudget;
+    if (blockId >= DPU_BLOCK_CNT || axiId >= AXI_PORT_MAX_CNT) return kNoBudget;
+
+    auto it = mTDMBudgets.find(display);
+    if (it == mTDMBudgets.end()) {
+        TDMBudget budget;
+        for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
+            for (uint32_t blk = 0; blk < DPU_BLOCK_CNT; blk++) {
+                for (uint32_t axi = 0; axi < AXI_PORT_MAX_CNT; axi++) {
+                    const uint32_t infoAXIId = (attr->second.loadSharing == LS_DPUF)
+                            ? static_cast<uint32_t>(AXI_DONT_CARE)
+                            : axi;
+                    const auto &TDMInfoIdx = std::make_pair(blk, infoAXIId);
+                    budget.amounts[blk][axi][attr->first] =
+                            display->mDisplayTDMInfo[TDMInfoIdx]
+                                    .getAvailableAmount(attr->first)
+                                    .totalAmount;
+                }
+            }
+        }
+        it = mTDMBudgets.emplace(display, budget).first;
+    }
+    return it->second.amounts[blockId][axiId];
+}
+
+void ExynosResourceManagerModule::hashTDMState(uint64_t &hash, uint64_t value) {
+    /* Spread the word before the FNV-1a step so that high bits reach the low ones */
+    value *= 0x9e3779b97f4a7c15ULL;
+    value ^= value >> 32;
+    hash ^= value;
+    hash *= 0x100000001b3ULL;
+}
+
+void ExynosResourceManagerModule::hashTDMSource(uint64_t &hash,
+                                                ExynosMPPSource *mppSrc) const {
+    auto pack = [](uint32_t high, uint32_t low) {
+        return (static_cast<uint64_t>(high) << 32) | low;
+    };
+    const exynos_image &src = mppSrc->mSrcImg;
+    const exynos_image &dst = mppSrc->mDstImg;
+    hashTDMState(hash, pack(src.format, src.compressionInfo.type));
+    hashTDMState(hash, pack(src.transform, mppSrc->mNeedPreblending));
+    hashTDMState(hash, pack(src.dataSpace, dst.dataSpace));
+    hashTDMState(hash, pack(src.x, src.y));
+    hashTDMState(hash, pack(src.w, src.h));
+    hashTDMState(hash, pack(dst.x, dst.y));
+    hashTDMState(hash, pack(dst.w, dst.h));
+    hashTDMState(hash, reinterpret_cast<uintptr_t>(mppSrc->mOtfMPP));
+    hashTDMState(hash, reinterpret_cast<uintptr_t>(mppSrc->mM2mMPP));
+    /* Amounts can also depend on the display state, e.g. HDR processing */
+    const TDMAmounts amounts = getTDMAmounts(mppSrc);
+    for (size_t lane = 0; lane < TDMAmounts::kLanes; lane += 2)
+        hashTDMState(hash, pack(amounts[lane], amounts[lane + 1]));
+}
+
+void ExynosResourceManagerModule::appendTDMImageState(std::vector<uint64_t> &state,
+                                                      ExynosMPPSource *mppSrc) {
+    auto pack = [](uint32_t high, uint32_t low) {
+        return (static_cast<uint64_t>(high) << 32) | low;
+    };
+    const exynos_image &src = mppSrc->mSrcImg;
+    const exynos_image &dst = mppSrc->mDstImg;
+    state.push_back(pack(src.format, src.compressionInfo.type));
+    state.push_back(pack(src.transform, mppSrc->mNeedPreblending));
+    state.push_back(pack(src.dataSpace, dst.dataSpace));
+    state.push_back(pack(src.x, src.y));
+    state.push_back(pack(src.w, src.h));
+    state.push_back(pack(dst.x, dst.y));
+    state.push_back(pack(dst.w, dst.h));
+}
+
+void ExynosResourceManagerModule::getTDMStackState(ExynosDisplay *display,
+                                                   std::vector<uint64_t> &state) const {
+    state.clear();
+    state.push_back((static_cast<uint64_t>(display->mXres) << 32) | display->mYres);
+    /* Windows are clipped to the update region */
+    if (mTDMUpdateRegion.display == display)
+        state.push_back((static_cast<uint64_t>(mTDMUpdateRegion.top) << 32) |
+                        static_cast<uint32_t>(mTDMUpdateRegion.bottom));
+    else
+        state.push_back(UINT64_MAX);
+    /* Layers in z-order, their amounts follow from the images like mHWResourceAmountCache */
+    for (auto layer : display->mLayers) {
+        state.push_back(reinterpret_cast<uintptr_t>(layer));
+        appendTDMImageState(state, layer);
+    }
+}
+
+void ExynosResourceManagerModule::getTDMAssignmentState(ExynosDisplay *display,
+                                                        std::vector<uint64_t> &state) const {
+    state.clear();
+    for (auto layer : display->mLayers) {
+        state.push_back(reinterpret_cast<uintptr_t>(layer->mOtfMPP));
+        state.push_back(reinterpret_cast<uintptr_t>(layer->mM2mMPP));
+    }
+    /* Composition targets are sized while the validate assigns layers */
+    for (ExynosCompositionInfo *info :
+         {&display->mExynosCompositionInfo, &display->mClientCompositionInfo}) {
+        state.push_back(info->mHasCompositionLayer);
+        if (!info->mHasCompositionLayer) continue;
+        state.push_back(reinterpret_cast<uintptr_t>(info->mOtfMPP));
+        state.push_back(reinterpret_cast<uintptr_t>(info->mM2mMPP));
+        appendTDMImageState(state, info);
+    }
+}
+
+void ExynosResourceManagerModule::getTDMRejectionState(ExynosDisplay *display,
+                                                       ExynosMPP *currentMPP,
+                                                       ExynosMPPSource *mppSrc,
+                                                       std::vector<uint64_t> &state) const {
+    state.clear();
+    state.push_back(reinterpret_cast<uintptr_t>(display));
+    state.push_back(reinterpret_cast<uintptr_t>(currentMPP));
+    state.push_back(reinterpret_cast<uintptr_t>(mppSrc));
+    state.push_back(reinterpret_cast<uintptr_t>(mppSrc->mOtfMPP));
+    state.push_back(reinterpret_cast<uintptr_t>(mppSrc->mM2mMPP));
+    appendTDMImageState(state, mppSrc);
+    /* Amounts can also depend on the display state, e.g. HDR processing */
+    const TDMAmounts amounts = getTDMAmounts(mppSrc);
+    for (size_t lane = 0; lane < TDMAmounts::kLanes; lane += 2)
+        state.push_back((static_cast<uint64_t>(amounts[lane]) << 32) | amounts[lane + 1]);
+    /* Windows are clipped to the update region */
+    if (mTDMUpdateRegion.display == display)
+        state.push_back((static_cast<uint64_t>(mTDMUpdateRegion.top) << 32) |
+                        static_cast<uint32_t>(mTDMUpdateRegion.bottom));
+    else
+        state.push_back(UINT64_MAX);
+    const auto &block = mTDMBlockStates[currentMPP->getHWBlockId()];
+    state.insert(state.end(), block.begin(), block.end());
+}
+
+bool ExynosResourceManagerModule::getOccupiedAmounts(
+        ExynosDisplay *display, uint32_t currentBlockId, uint32_t currentAXIId,
+        ExynosMPPSource *curSrc, const TDMOccupancy &occupancy, TDMAmounts &DPUFAmounts,
+        TDMAmounts &AXIAmounts) {
+    int32_t top, bottom;
+    getTDMSpan(display, curSrc->mSrcImg, curSrc->mDstImg, top, bottom);
+    /* Outside the update region, nothing is scanned out with it */
+    if (top > bottom) return true;
+    if (!occupancy.query(currentBlockId, currentAXIId, top, bottom, DPUFAmounts, AXIAmounts))
+        return false;
+
+    /* An assigned layer is part of the occupancy, it should not be compared with itself */
+    ExynosMPP *otfMPP = (curSrc->mSourceType == MPP_SOURCE_LAYER) ? curSrc->mOtfMPP : nullptr;
+    if (otfMPP && (otfMPP->getHWBlockId() == currentBlockId) &&
+        isOverlapped(display, curSrc, curSrc)) {
+        const TDMAmounts amounts = getTDMAmounts(curSrc);
+        DPUFAmounts -= amounts;
+        if (otfMPP->getAXIPortId() == currentAXIId) AXIAmounts -= amounts;
+    }
+
+    return true;
+}
+
+void ExynosResourceManagerModule::dump(String8 &result) const {
+    gs201::ExynosResourceManagerModule::dump(result);
+    dumpTDMStats(result);
+}
+
+void ExynosResourceManagerModule::dumpTDMStats(String8 &result) const {
+    result.appendFormat("TDM assignment stats\n");
+    if (!mTDMCallStats) result.appendFormat("\tcall timing off (vendor.display.tdm.call_stats)\n");
+    TDMStats::dumpCallStats(result, "isHWResourceAvailable", mTDMStats.availability);
+    TDMStats::dumpCallStats(result, "otfMppReordering", mTDMStats.reordering);
+    TDMStats::dumpCallStats(result, "TDMAssignSolver", mTDMStats.solver);
+    TDMStats::dumpCallStats(result, "setDisplaysTDMInfo", mTDMStats.budgetUpdate);
+    TDMStats::dumpCallStats(result, "initDisplaysTDMInfo", mTDMStats.budgetInit);
+    result.appendFormat("\tsplit budget entries : %" PRIu64 "\n", mTDMStats.budgetEntries.get());
+    result.appendFormat("\treused decisions : %" PRIu64 "\n", mTDMStats.reusedDecisions.get());
+    result.appendFormat("\trejection cache : hits %" PRIu64 ", misses %" PRIu64 "\n",
+                        mTDMStats.rejectionCacheHits.get(), mTDMStats.rejectionCacheMisses.get());
+    result.appendFormat("\tfiltered candidates : %" PRIu64 "\n",
+                        mTDMStats.filteredCandidates.get());
+    result.appendFormat("\tsolver skipped, frame budget used up : %" PRIu64 "\n",
+                        mTDMStats.solverSkipped.get());
+    result.appendFormat("\tpartial update presents : %" PRIu64 "\n",
+                        mTDMStats.partialUpdatePresents.get());
+    result.appendFormat("\tpacking policy %u (max layers %d) : packed %" PRIu64
+                        ", spread %" PRIu64 "\n",
+                        mPackingPolicy.load(std::memory_order_relaxed), mPackingMaxLayers,
+                        mTDMStats.packedReorderings.get(), mTDMStats.spreadReorderings.get());
+    result.appendFormat("\trejected by :");
+    for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
+        result.appendFormat(" %s(%" PRIu64 ")", attr->second.name.c_str(),
+                            mTDMStats.rejectedBy[attr->first].get());
+    }
+    result.appendFormat("\n");
+
+    result.appendFormat("TDM utilization\n");
+    for (auto &display : mDisplays) {
+        mTDMUtilization.dump(result, getTDMDisplaySlot(display), display->mDisplayName.c_str());
+    }
+
+    result.appendFormat("TDM reach (bit DPUF * %d + AXI)\n", AXI_PORT_MAX_CNT);
+    for (auto &display : mDisplays) {
+        const uint32_t slot = getTDMDisplaySlot(display);
+        if (slot >= mTDMReachDump.size()) continue;
+        const uint32_t reach = mTDMReachDump[slot].load(std::memory_order_relaxed);
+        if (reach != kNoTDMReach)
+            result.appendFormat("\t%s : 0x%x\n", display->mDisplayName.c_str(), reach);
+    }
+
+    mTDMRejectionLog.dump(result);
+}
+
+uint32_t ExynosResourceManagerModule::getTDMDisplaySlot(ExynosDisplay *display) const {
+    for (uint32_t slot = 0; slot < mDisplays.size(); slot++) {
+        if (mDisplays[slot] == display) return slot;
+    }
+    return TDMUtilization::kMaxDisplays;
+}
+
+void ExynosResourceManagerModule::onTDMValidate(ExynosDisplay *display) {
+    const uint32_t displaySlot = getTDMDisplaySlot(display);
+    if (displaySlot < 32) mTDMValidateHooks |= 1u << displaySlot;
+    mTDMCheckDisplay = display;
+    mTDMChecksPending = true;
+    mOtfCandidates = {nullptr, nullptr, kAllOtfCandidates};
+    mTDMSolverDisplay = display;
+    mTDMSolverTimeLeft = kTDMSolverFrameBudget;
+    updateTDMDemand(display);
+}
+
+ExynosLayer *ExynosResourceManagerModule::getTDMCurrentLayer(ExynosDisplay *display,
+                                                             const exynos_image &src,
+                                                             const exynos_image &dst) const {
+    auto isSameImage = [](const exynos_image &lhs, const exynos_image &rhs) {
+        return (lhs.bufferHandle == rhs.bufferHandle) && (lhs.format == rhs.format) &&
+                (lhs.compressionInfo.type == rhs.compressionInfo.type) &&
+                (lhs.transform == rhs.transform) && (lhs.dataSpace == rhs.dataSpace) &&
+                (lhs.x == rhs.x) && (lhs.y == rhs.y) && (lhs.w == rhs.w) && (lhs.h == rhs.h);
+    };
+    /*
+     * The images are copies of the layer's, set just before the reordering. Layers are
+     * assigned in z-order, so it is the first one without a channel that shows them.
+     */
+    for (auto layer : display->mLayers) {
+        if (layer->mOtfMPP || (layer->mValidateCompositionType == HWC2_COMPOSITION_CLIENT))
+            continue;
+        if (isSameImage(layer->mSrcImg, src) && isSameImage(layer->mDstImg, dst)) return layer;
+    }
+    return nullptr;
+}
+
+void ExynosResourceManagerModule::reorderOtfMppsBySolver(ExynosDisplay *display,
+                                                         ExynosMPPVector &otfMPPs,
+                                                         struct exynos_image &src,
+                                                         struct exynos_image &dst) {
+    ExynosLayer *current = getTDMCurrentLayer(display, src, dst);
+    if (current == nullptr) return;
+
+    /* A display validated without onTDMValidate() starts its frame at its first search */
+    if (mTDMSolverDisplay != display) {
+        mTDMSolverDisplay = display;
+        mTDMSolverTimeLeft = kTDMSolverFrameBudget;
+    }
+    if (mTDMSolverTimeLeft <= 0) {
+        mTDMStats.solverSkipped.add();
+        return;
+    }
+
+    TDMStatsScope statsScope(mTDMStats.solver, mTDMCallStats);
+    statsScope.setPassed(false);
+
+    TDMAssignSolver::Budgets budgets{};
+    std::array<bool, TDM_ATTR_MAX> perAXI{};
+    for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++) {
+        perAXI[attr->first] = (attr->second.loadSharing == LS_DPUF_AXI);
+        for (uint32_t blkId = 0; blkId < DPU_BLOCK_CNT; blkId++) {
+            for (uint32_t axiId = 0; axiId < AXI_PORT_MAX_CNT; axiId++) {
+                const auto &TDMInfoIdx =
+                        std::make_pair(blkId,
+                                       perAXI[attr->first] ? axiId
+                                                           : static_cast<uint32_t>(AXI_DONT_CARE));
+                budgets[blkId][axiId][attr->first] = display->mDisplayTDMInfo[TDMInfoIdx]
+                                                             .getAvailableAmount(attr->first)
+                                                             .totalAmount;
+            }
+        }
+    }
+
+    TDMAssignSolver solver(budgets, perAXI);
+    auto makeSource = [&](const exynos_image &srcImg, const exynos_image &dstImg,
+                          const std::array<uint32_t, TDM_ATTR_MAX> &amounts) {
+        TDMAssignSolver::Source source{};
+        getTDMExtent(display, srcImg, dstImg, source.top, source.bottom);
+        getTDMSpan(display, srcImg, dstImg, source.spanTop, source.spanBottom);
+        source.yuv = isFormatYUV(srcImg.format);
+        /* Format, AFBC, rotation and scaling restrictions of the channels */
+        source.candidates = getOtfCandidateMask(display, srcImg, dstImg);
+        /* Outside the update region, it takes no line time in this frame */
+        if (source.top <= source.bottom) source.amounts = amounts;
+        return source;
+    };
+    auto addAssigned = [&](ExynosMPPSource *mppSrc) {
+        std::array<uint32_t, TDM_ATTR_MAX> amounts{};
+        for (auto attr = HWAttrs.begin(); attr != HWAttrs.end(); attr++)
+            amounts[attr->first] = mppSrc->getHWResourceAmount(attr->first);
+        solver.addAssigned(makeSource(mppSrc->mSrcImg, mppSrc->mDstImg, amounts),
+                           mppSrc->mOtfMPP->getHWBlockId(), mppSrc->mOtfMPP->getAXIPortId());
+    };
+
+    std::array<uint32_t, TDM_ATTR_MAX> amounts{};
+    getHWResourceAmounts(display, src, dst, amounts);
+    solver.addPending(makeSource(src, dst, amounts));
+
+    const ExynosCompositionInfo &client = display->mClientCompositionInfo;
+    for (size_t i = 0; i < display->mLayers.size(); i++) {
+        ExynosLayer *layer = display->mLayers[i];
+        if (layer == current) continue;
+        if (layer->mOtfMPP) {
+            addAssigned(layer);
+            continue;
+        }
+        /* Layers composited by the client or an m2m MPP don't need a channel of their own */
+        const bool clientComposited =
+                (layer->mValidateCompositionType == HWC2_COMPOSITION_CLIENT) ||
+                (client.mHasCompositionLayer && (static_cast<int32_t>(i) >= client.mFirstIndex) &&
+                 (static_cast<int32_t>(i) <= client.mLastIndex));
+        if (clientComposited || layer->mM2mMPP) continue;
+        getHWResourceAmounts(display, layer->mSrcImg, layer->mDstImg, amounts);
+        solver.addPending(makeSource(layer->mSrcImg, layer->mDstImg, amounts));
+    }
+    if (display->mExynosCompositionInfo.mHasCompositionLayer &&
+        display->mExynosCompositionInfo.mOtfMPP)
+        addAssigned(&display->mExynosCompositionInfo);
+    if (display->mClientCompositionInfo.mHasCompositionLayer &&
+        display->mClientCompositionInfo.mOtfMPP)
+        addAssigned(&display->mClientCompositionInfo);
+
+    std::vector<TDMAssignSolver::Channel> channels;
+    std::vector<size_t> channelMPPIndex;
+    for (size_t i = 0; i < otfMPPs.size(); i++) {
+        ExynosMPPModule *mpp = (ExynosMPPModule *)otfMPPs[i];
+        if (!mpp->isAssignableState(display, src, dst)) continue;
+        channels.push_back({mpp->getHWBlockId(), mpp->getAXIPortId(),
+                            mpp->mPhysicalType == MPP_DPP_VGRFS, getOtfChannelBit(mpp)});
+        channelMPPIndex.push_back(i);
+    }
+
+    /* Every search of the frame shares kTDMSolverFrameBudget */
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    const int32_t channel =
+            solver.solve(channels,
+                         std::min(TDMAssignSolver::kDefaultTimeBudget, mTDMSolverTimeLeft));
+    mTDMSolverTimeLeft -= systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    HDEBUGLOGD(eDebugLoadBalancing, "%s: layer %p channel %d, %d layers fit, %zu nodes",
+               __func__, current, channel, solver.getBestCount(), solver.getVisitedNodes());
+    if (channel < 0) return;
+
+    /* Keep the greedy order for the others, they are tried if the first one is not assignable */
+    const auto first = otfMPPs.begin() + channelMPPIndex[channel];
+    std::rotate(otfMPPs.begin(), first, first + 1);
+    statsScope.setPassed(true);
+}
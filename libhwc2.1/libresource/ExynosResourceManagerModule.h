@@ -17,7 +17,17 @@
 #ifndef _EXYNOS_RESOURCE_MANAGER_MODULE_ZUMA_H
 #define _EXYNOS_RESOURCE_MANAGER_MODULE_ZUMA_H
 
+#include <atomic>
+#include <unordered_map>
+
 #include "../../gs201/libhwc2.1/libresource/ExynosResourceManagerModule.h"
+#include "TDMAssignSolver.h"
+#include "TDMOccupancy.h"
+#include "TDMPartitioner.h"
+#include "TDMRejectionLog.h"
+#include "TDMStats.h"
+#include "TDMUtilization.h"
+#include "TDMWindow.h"
 
 namespace zuma {
 
@@ -40,18 +50,313 @@ class ExynosResourceManagerModule : public gs201::ExynosResourceManagerModule {
         uint32_t getAmounts(ExynosDisplay* display, uint32_t currentBlockId, uint32_t currentAXIId,
                             ExynosMPP* compOtfMPP, ExynosMPPSource* curSrc,
                             ExynosMPPSource* compSrc,
-                            std::array<uint32_t, TDM_ATTR_MAX>& DPUFAmounts,
-                            std::array<uint32_t, TDM_ATTR_MAX>& AXIAmounts);
+                            TDMAmounts& DPUFAmounts, TDMAmounts& AXIAmounts);
         bool checkTDMResource(ExynosDisplay *display, ExynosMPP *currentMPP,
-                              ExynosMPPSource *mppSrc);
-        const std::map<HWResourceIndexes, HWResourceAmounts_t> *mHWResourceTables = nullptr;
+                              ExynosMPPSource *mppSrc,
+                              const TDMOccupancy *occupancy = nullptr);
+        const HWResourceBudgetTable *mHWResourceTables = nullptr;
         void setupHWResource(const tdm_attr_t &tdmAttrId, const String8 &name,
                              const DPUblockId_t &blkId, const AXIPortId_t &axiId,
-                             ExynosDisplay *display, ExynosDisplay *addedDisplay,
-                             const ConstraintRev_t &constraintsRev);
+                             ExynosDisplay *display, const ConstraintRev_t &constraintsRev);
+
+        /* Called when a validate of display starts, before any of its resources are assigned */
+        void onTDMValidate(ExynosDisplay *display);
+        /* Called when a frame of display is committed, with the assignment of its validate */
+        void onTDMPresent(ExynosDisplay *display);
+
+        /* Can be changed at any time, e.g. when battery saver is turned on */
+        void setPackingPolicy(packingPolicy_t policy);
+
+        virtual void dump(String8 &result) const;
+        void dumpTDMStats(String8 &result) const;
 
     private:
+        /* Amounts of every (DPUF, AXI), LS_DPUF lanes are the same for both AXI ports */
+        struct TDMBudget {
+            TDMAmounts amounts[DPU_BLOCK_CNT][AXI_PORT_MAX_CNT];
+        };
+        /* Inputs of calculateHWResourceAmount() */
+        struct HWResourceAmountKey {
+            ExynosDisplay *display;
+            uint32_t format;
+            uint32_t srcW;
+            uint32_t srcH;
+            uint32_t transform;
+            uint32_t compressType;
+            android_dataspace srcDataSpace;
+            uint32_t dstW;
+            uint32_t dstH;
+            android_dataspace dstDataSpace;
+
+            bool operator==(const HWResourceAmountKey &rhs) const {
+                return display == rhs.display && format == rhs.format && srcW == rhs.srcW &&
+                        srcH == rhs.srcH && transform == rhs.transform &&
+                        compressType == rhs.compressType && srcDataSpace == rhs.srcDataSpace &&
+                        dstW == rhs.dstW && dstH == rhs.dstH && dstDataSpace == rhs.dstDataSpace;
+            }
+        };
+        struct HWResourceAmountCache {
+            HWResourceAmountKey key;
+            std::array<uint32_t, TDM_ATTR_MAX> amounts;
+        };
+        static constexpr size_t kMaxHWResourceAmountCacheSize = 64;
+
+        static HWResourceAmountKey getHWResourceAmountKey(ExynosDisplay *display,
+                                                          ExynosMPPSource *mppSrc);
+        uint32_t getHWResourceAmounts(ExynosDisplay *display, exynos_image &src,
+                                      exynos_image &dst,
+                                      std::array<uint32_t, TDM_ATTR_MAX> &amounts);
+        /* Whether otfMppReordering() consolidates layers of the display onto PACKING_BLOCK */
+        bool isPacking(ExynosDisplay *display) const;
+        /* Peak DRAM read bandwidth of a source in bytes per second */
+        static uint64_t getReadBandwidth(ExynosDisplay *display, const exynos_image &src,
+                                         const exynos_image &dst);
+        /*
+         * Scanlines a source occupies when it is checked (span) and when it is compared
+         * with (extent): its destination lines plus the lines fetched ahead of them, see
+         * getTDMFetchMargin() and getTDMWindowLines() for why only the top is padded.
+         * mFixedOverlapMargin pads the span only, by TDM_OVERLAP_MARGIN in both directions.
+         */
+        void getTDMWindow(ExynosDisplay *display, const exynos_image &src,
+                          const exynos_image &dst, bool current, int32_t &top,
+                          int32_t &bottom) const;
+        void getTDMSpan(ExynosDisplay *display, const exynos_image &src,
+                        const exynos_image &dst, int32_t &top, int32_t &bottom) const;
+        void getTDMExtent(ExynosDisplay *display, const exynos_image &src,
+                          const exynos_image &dst, int32_t &top, int32_t &bottom) const;
+        /* Lines of the display scanned out by the commit it has delivered */
+        void updateTDMUpdateRegion(ExynosDisplay *display);
+        void reorderOtfMppsBySolver(ExynosDisplay *display, ExynosMPPVector &otfMPPs,
+                                    struct exynos_image &src, struct exynos_image &dst);
+        /* Layer of the images otfMppReordering() is called with, nullptr if none */
+        ExynosLayer *getTDMCurrentLayer(ExynosDisplay *display, const exynos_image &src,
+                                        const exynos_image &dst) const;
+        /* Amounts of displays for the resource, with what they requested and its total */
+        std::vector<uint32_t> getHWResourcePartition(const tdm_attr_t &tdmAttrId,
+                                                     const String8 &name,
+                                                     const DPUblockId_t &blkId,
+                                                     const AXIPortId_t &axiId,
+                                                     const std::vector<ExynosDisplay *> &displays,
+                                                     const std::vector<uint32_t> &reachMasks,
+                                                     std::vector<TDMResourceRequest> &requests,
+                                                     uint32_t &total);
+        void partitionHWResource(const tdm_attr_t &tdmAttrId, const String8 &name,
+                                 const DPUblockId_t &blkId, const AXIPortId_t &axiId,
+                                 const std::vector<ExynosDisplay *> &displays,
+                                 const std::vector<uint32_t> &reachMasks);
+        /* Log and split again a resource whose kept amounts differ from a full split */
+        void checkHWResourcePartition(const tdm_attr_t &tdmAttrId, const String8 &name,
+                                      const DPUblockId_t &blkId, const AXIPortId_t &axiId,
+                                      const std::vector<ExynosDisplay *> &displays,
+                                      const std::vector<uint32_t> &reachMasks);
+        /* Enabled displays in split priority order, see setDisplaysTDMInfo() */
+        std::vector<ExynosDisplay *> getTDMSplitDisplays();
+        /* Track the demand of display at its validate, split again if it changed */
+        void updateTDMDemand(ExynosDisplay *display);
+        /* Busiest scanline of the layers of display, whatever channels they get */
+        void getTDMStackDemand(ExynosDisplay *display, TDMAmounts &demand);
+        /* Busiest scanline of what display has on each (DPUF, AXI) */
+        void getTDMAssignedPeak(ExynosDisplay *display, TDMBudget &peak);
+        /* Split every resource again with the demands of mTDMDemands */
+        void splitTDMResourcesByDemand();
+        /* Bit of the display in the pre-assignment info of otf MPPs */
+        static uint32_t getPreAssignDisplayBit(ExynosDisplay *display);
+        /* Bit blockId * AXI_PORT_MAX_CNT + axiId, every AXI port of the DPUF for AXI_DONT_CARE */
+        static uint32_t getTDMReachMask(uint32_t blockId, uint32_t axiId);
+        /* Bit i of a candidate mask is mOtfChannels[i] */
+        void buildOtfChannelMasks();
+        /*
+         * Channels whose format, MPP_ATTR and display pre-assignment allow the layer,
+         * kAllOtfCandidates if the channels are not indexed. A format without any
+         * restriction entry is allowed on every channel.
+         */
+        uint32_t getOtfCandidateMask(ExynosDisplay *display, const exynos_image &src,
+                                     const exynos_image &dst);
+        /* Bit of mpp in candidate masks, 0 if it is not indexed */
+        uint32_t getOtfChannelBit(ExynosMPP *mpp) const;
+        bool isOtfCandidate(uint32_t candidates, ExynosMPP *mpp) const;
+        bool isFilteredOtfCandidate(ExynosDisplay *display, ExynosMPP *currentMPP,
+                                    ExynosMPPSource *mppSrc);
+        /* (DPUF, AXI) pairs each display has channels on that no other enabled display reserves */
+        std::vector<uint32_t> getTDMReachMasks(const std::vector<ExynosDisplay *> &displays);
+        /* Reach bits whose split can change since the last setDisplaysTDMInfo() */
+        uint32_t getChangedTDMReach(
+                const std::unordered_map<ExynosDisplay *, uint32_t> &previousReach);
+        /* Index of the display in TDMUtilization, kMaxDisplays if it has none */
+        uint32_t getTDMDisplaySlot(ExynosDisplay *display) const;
+        void buildTDMOccupancy(ExynosDisplay *display);
+        bool getOccupiedAmounts(ExynosDisplay *display, uint32_t currentBlockId,
+                                uint32_t currentAXIId, ExynosMPPSource *curSrc,
+                                const TDMOccupancy &occupancy, TDMAmounts &DPUFAmounts,
+                                TDMAmounts &AXIAmounts);
+        TDMAmounts getTDMAmounts(ExynosMPPSource *mppSrc) const;
+        bool checkHWResourceAvailable(ExynosDisplay *display, ExynosMPP *currentMPP,
+                                      ExynosMPPSource *mppSrc);
+        /* Update region and decision cache of display, once per validate or per check */
+        void prepareTDMChecks(ExynosDisplay *display);
+        /* Stack of the display, and what its layers are assigned to so far */
+        void getTDMStackState(ExynosDisplay *display, std::vector<uint64_t> &state) const;
+        void getTDMAssignmentState(ExynosDisplay *display, std::vector<uint64_t> &state) const;
+        static void appendTDMImageState(std::vector<uint64_t> &state, ExynosMPPSource *mppSrc);
+        static void hashTDMState(uint64_t &hash, uint64_t value);
+        void hashTDMSource(uint64_t &hash, ExynosMPPSource *mppSrc) const;
+        /* Assigned sources, update region and budgets of display at its present */
+        uint64_t getTDMPresentHash(ExynosDisplay *display);
+        /* Candidate, MPP and the sources in its DPUF, valid after buildTDMOccupancy() */
+        void getTDMRejectionState(ExynosDisplay *display, ExynosMPP *currentMPP,
+                                  ExynosMPPSource *mppSrc, std::vector<uint64_t> &state) const;
+        /* Totals of mDisplayTDMInfo, LS_DPUF lanes hold the AXI_DONT_CARE amounts */
+        const TDMAmounts &getTDMBudget(ExynosDisplay *display, uint32_t blockId,
+                                       uint32_t axiId);
+
         ConstraintRev_t mConstraintRev;
+        /* Lanes of LS_DPUF_AXI attributes */
+        uint32_t mPerAXIAttrMask = 0;
+        /* Cleared whenever mDisplayTDMInfo is updated */
+        std::unordered_map<ExynosDisplay *, TDMBudget> mTDMBudgets;
+        /* Search the channel that keeps the most layers on DPP instead of greedy ordering */
+        bool mOptimalOtfAssign = false;
+        /* Search time of a validate, greedy ordering is kept once it is used up */
+        static constexpr nsecs_t kTDMSolverFrameBudget = 1000000; /* 1ms */
+        ExynosDisplay *mTDMSolverDisplay = nullptr;
+        nsecs_t mTDMSolverTimeLeft = 0;
+        /* Reuse isHWResourceAvailable() results while the display state is unchanged */
+        bool mReuseTDMDecisions = true;
+        /*
+         * Balance AXI ports and DPUFs by read bandwidth before counts of assigned MPPs.
+         * Off until getReadBandwidth() has measured compression ratios.
+         */
+        bool mBandwidthBalancing = false;
+        std::atomic<uint32_t> mPackingPolicy{PACKING_SPREAD};
+        /* Most layers a display can have for PACKING_LIGHT_LOAD to pack them */
+        int32_t mPackingMaxLayers = 4;
+        /* Only sort and check the channels the layer's format and features allow */
+        bool mFilterOtfCandidates = true;
+        /* Candidate masks have a bit per channel */
+        static constexpr size_t kMaxOtfChannels = 32;
+        static_assert(kMaxOtfChannels <= sizeof(uint32_t) * 8, "candidate masks are uint32_t");
+        static constexpr uint32_t kMaxAttrBits = 64;
+        static constexpr uint32_t kAllOtfCandidates = UINT32_MAX;
+        std::vector<ExynosMPP *> mOtfChannels;
+        /* Channels supporting a format, an MPP_ATTR bit and pre-assigned to a display bit */
+        std::unordered_map<uint32_t, uint32_t> mOtfFormatMasks;
+        uint32_t mOtfAttrMasks[kMaxAttrBits] = {};
+        uint32_t mOtfPreAssignMasks[32] = {};
+        /* Candidates of the last source isHWResourceAvailable() was called for */
+        struct OtfCandidates {
+            ExynosDisplay *display;
+            ExynosMPPSource *source;
+            uint32_t mask;
+        };
+        /* Reset when a validate starts or ends, a source keeps its images during a validate */
+        OtfCandidates mOtfCandidates = {nullptr, nullptr, kAllOtfCandidates};
+        /* Clip TDM windows of presents to the update region of partial updates */
+        bool mPartialUpdateTDM = false;
+        /* Windows of display are clipped to [top, bottom], nullptr for a full update */
+        struct TDMUpdateRegion {
+            ExynosDisplay *display;
+            int32_t top;
+            int32_t bottom;
+        };
+        TDMUpdateRegion mTDMUpdateRegion = {nullptr, 0, 0};
+        /*
+         * Pad overlap checks by TDM_OVERLAP_MARGIN instead of each source's fetch margin,
+         * the fetch margin model is opt-in until its line counts are confirmed
+         */
+        bool mFixedOverlapMargin = true;
+        /* Give displays amounts only on the DPUFs and AXI ports they have channels on */
+        bool mJointPlanning = true;
+        /* getTDMReachMasks() of the last setDisplaysTDMInfo() */
+        std::unordered_map<ExynosDisplay *, uint32_t> mTDMReachMasks;
+        /* Copy of mTDMReachMasks by getTDMDisplaySlot() for dumpsys, kNoTDMReach if none */
+        static constexpr uint32_t kNoTDMReach = UINT32_MAX;
+        std::array<std::atomic<uint32_t>, TDMUtilization::kMaxDisplays> mTDMReachDump{};
+        /* Enabled state of the displays at the last setDisplaysTDMInfo() */
+        std::unordered_map<ExynosDisplay *, bool> mTDMEnabledDisplays;
+        /* Whether every amount has been split since initDisplaysTDMInfo() */
+        bool mTDMPartitioned = false;
+        /*
+         * Split by what displays other than the primary display need instead of their
+         * maxAssignedAmount, see getHWResourcePartition()
+         */
+        bool mDemandSplit = true;
+        /* Validates of other displays after which a display that has none is idle */
+        static constexpr uint64_t kTDMIdleValidates = 120;
+        struct TDMDemand {
+            /* Validated since it was enabled, the table caps are used until then */
+            bool known = false;
+            bool idle = false;
+            uint64_t lastValidate = 0;
+            /* getTDMStackDemand() at its last validate */
+            TDMAmounts stack;
+            /* getTDMAssignedPeak() at the last split, what it keeps on screen */
+            TDMBudget assigned;
+        };
+        /* By getTDMDisplaySlot(), only changed by setDisplaysTDMInfo() and updateTDMDemand() */
+        std::array<TDMDemand, TDMUtilization::kMaxDisplays> mTDMDemands;
+        uint64_t mTDMValidates = 0;
+        /* Display whose checks prepareTDMChecks() has prepared, and whether it should again */
+        ExynosDisplay *mTDMCheckDisplay = nullptr;
+        bool mTDMChecksPending = true;
+        /* Bits of the slots of displays whose validates call onTDMValidate() */
+        uint32_t mTDMValidateHooks = 0;
+        static constexpr size_t kMaxTDMDecisions = 1024;
+        struct TDMDecision {
+            ExynosMPP *currentMPP;
+            ExynosMPPSource *mppSrc;
+            std::vector<uint64_t> assignment;
+            bool available;
+            /* Attribute that rejected it, TDM_ATTR_MAX if it is available */
+            uint32_t rejectedBy;
+        };
+        struct TDMDecisions {
+            std::vector<uint64_t> stack;
+            /* Hash of the candidate MPP, source and assignment -> decision */
+            std::unordered_map<uint64_t, TDMDecision> decisions;
+        };
+        std::unordered_map<ExynosDisplay *, TDMDecisions> mTDMDecisions;
+        std::vector<uint64_t> mTDMStackState;
+        std::vector<uint64_t> mTDMAssignmentState;
+        /* Attribute of the last rejection of checkTDMResource() */
+        uint32_t mTDMRejectedBy = TDM_ATTR_MAX;
+        /* Assigned sources of the display being checked by isHWResourceAvailable() */
+        TDMOccupancy mTDMOccupancy;
+        /* Layer of each source of mTDMOccupancy, nullptr for composition targets */
+        std::array<ExynosLayer *, TDMOccupancy::kMaxSources> mTDMOccupancyLayers = {};
+        /* Sources of mTDMOccupancy in each DPUF, with their window and amounts */
+        std::vector<uint64_t> mTDMBlockStates[DPU_BLOCK_CNT];
+        /* Skip checkTDMResource() of combinations it has rejected since the last budget update */
+        bool mCacheTDMRejections = true;
+        static constexpr size_t kMaxTDMRejections = 512;
+        struct TDMRejection {
+            std::vector<uint64_t> state;
+            tdm_attr_t attr;
+        };
+        /* Hash of getTDMRejectionState() -> rejection */
+        std::unordered_map<uint64_t, TDMRejection> mTDMRejections;
+        std::vector<uint64_t> mTDMRejectionState;
+        /* Last amounts of each source, reused while its key is unchanged */
+        std::unordered_map<ExynosMPPSource *, HWResourceAmountCache> mHWResourceAmountCache;
+        TDMStats mTDMStats;
+        /* Time resource manager calls into mTDMStats, two clock reads per call */
+        bool mTDMCallStats = false;
+        TDMUtilization mTDMUtilization;
+        /* Utilization samples of the last present of each display, by getTDMDisplaySlot() */
+        struct TDMPresentSample {
+            uint32_t attr;
+            uint32_t blockId;
+            uint32_t axiId;
+            uint32_t used;
+            uint32_t total;
+        };
+        struct TDMPresentState {
+            bool valid = false;
+            /* getTDMPresentHash() the samples were taken at */
+            uint64_t hash = 0;
+            std::vector<TDMPresentSample> samples;
+        };
+        std::array<TDMPresentState, TDMUtilization::kMaxDisplays> mTDMPresents;
+        TDMRejectionLog mTDMRejectionLog;
 };
 
 }  // namespace zuma
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_AMOUNTS_ZUMA_H
+#define _TDM_AMOUNTS_ZUMA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace zuma {
+
+/*
+ * Amounts of every TDM attribute, one 32-bit lane per tdm_attr_t padded to two 128-bit
+ * vectors. Unused lanes stay zero so that they never exceed a budget.
+ * It has no HWC dependency so that host tests and benchmarks can build it.
+ */
+struct alignas(16) TDMAmounts {
+    static constexpr size_t kLanes = 8;
+
+    uint32_t lanes[kLanes] = {};
+
+    uint32_t &operator[](size_t attr) { return lanes[attr]; }
+    const uint32_t &operator[](size_t attr) const { return lanes[attr]; }
+
+    TDMAmounts &operator+=(const TDMAmounts &rhs) {
+#if defined(__ARM_NEON)
+        vst1q_u32(lanes, vaddq_u32(vld1q_u32(lanes), vld1q_u32(rhs.lanes)));
+        vst1q_u32(lanes + 4, vaddq_u32(vld1q_u32(lanes + 4), vld1q_u32(rhs.lanes + 4)));
+#else
+        for (size_t i = 0; i < kLanes; i++) lanes[i] += rhs.lanes[i];
+#endif
+        return *this;
+    }
+
+    TDMAmounts &operator-=(const TDMAmounts &rhs) {
+#if defined(__ARM_NEON)
+        vst1q_u32(lanes, vsubq_u32(vld1q_u32(lanes), vld1q_u32(rhs.lanes)));
+        vst1q_u32(lanes + 4, vsubq_u32(vld1q_u32(lanes + 4), vld1q_u32(rhs.lanes + 4)));
+#else
+        for (size_t i = 0; i < kLanes; i++) lanes[i] -= rhs.lanes[i];
+#endif
+        return *this;
+    }
+
+    friend TDMAmounts operator+(TDMAmounts lhs, const TDMAmounts &rhs) { return lhs += rhs; }
+
+    /* Bit i is set if lane i is greater than lane i of rhs */
+    uint32_t greaterThan(const TDMAmounts &rhs) const {
+#if defined(__ARM_NEON)
+        static const uint32_t kBits[kLanes] = {1 << 0, 1 << 1, 1 << 2, 1 << 3,
+                                               1 << 4, 1 << 5, 1 << 6, 1 << 7};
+        const uint32x4_t lo = vandq_u32(vcgtq_u32(vld1q_u32(lanes), vld1q_u32(rhs.lanes)),
+                                        vld1q_u32(kBits));
+        const uint32x4_t hi =
+                vandq_u32(vcgtq_u32(vld1q_u32(lanes + 4), vld1q_u32(rhs.lanes + 4)),
+                          vld1q_u32(kBits + 4));
+        const uint32x4_t bits = vorrq_u32(lo, hi);
+        return vgetq_lane_u32(bits, 0) | vgetq_lane_u32(bits, 1) | vgetq_lane_u32(bits, 2) |
+                vgetq_lane_u32(bits, 3);
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kLanes; i++) mask |= (lanes[i] > rhs.lanes[i]) << i;
+        return mask;
+#endif
+    }
+
+    /* Lanes whose bit is set in laneMask come from set, the others from unset */
+    static TDMAmounts select(uint32_t laneMask, const TDMAmounts &set, const TDMAmounts &unset) {
+        TDMAmounts result;
+        for (size_t i = 0; i < kLanes; i++)
+            result.lanes[i] = ((laneMask >> i) & 1) ? set.lanes[i] : unset.lanes[i];
+        return result;
+    }
+};
+
+} // namespace zuma
+
+#endif // _TDM_AMOUNTS_ZUMA_H
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TDMAssignSolver.h"
+
+#include <algorithm>
+
+using namespace zuma;
+
+void TDMAssignSolver::addAssigned(const Source &source, uint32_t blockId, uint32_t axiId) {
+    if (blockId >= DPU_BLOCK_CNT || axiId >= AXI_PORT_MAX_CNT) return;
+
+    /* Assigned sources are checked as they are, only their accumulation is updated */
+    place(source, blockId, axiId);
+}
+
+void TDMAssignSolver::addPending(const Source &source) {
+    if (mPending.size() < kMaxSources) mPending.push_back(source);
+}
+
+bool TDMAssignSolver::isOverBudget(const Placed &placed) const {
+    for (size_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+        const uint32_t accumulated =
+                mPerAXI[attr] ? placed.AXIAmounts[attr] : placed.DPUFAmounts[attr];
+        if (accumulated + placed.source.amounts[attr] >
+            mBudgets[placed.blockId][placed.axiId][attr])
+            return true;
+    }
+    return false;
+}
+
+bool TDMAssignSolver::place(const Source &source, uint32_t blockId, uint32_t axiId) {
+    Placed current{source, blockId, axiId, {}, {}};
+    for (auto &placed : mPlaced) {
+        if (placed.blockId != blockId) continue;
+        if (isOverlapped(source, placed.source)) {
+            for (size_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+                current.DPUFAmounts[attr] += placed.source.amounts[attr];
+                if (placed.axiId == axiId) current.AXIAmounts[attr] += placed.source.amounts[attr];
+            }
+        }
+    }
+    const bool isPending = !mClasses.empty();
+    if (isPending && isOverBudget(current)) return false;
+
+    /* Sources overlapping the new one lose budget as well */
+    bool fit = true;
+    for (auto &placed : mPlaced) {
+        if ((placed.blockId != blockId) || !isOverlapped(placed.source, source)) continue;
+        for (size_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+            placed.DPUFAmounts[attr] += source.amounts[attr];
+            if (placed.axiId == axiId) placed.AXIAmounts[attr] += source.amounts[attr];
+        }
+        if (isPending && isOverBudget(placed)) fit = false;
+    }
+    mPlaced.push_back(current);
+
+    if (!fit) {
+        unplace();
+        return false;
+    }
+    return true;
+}
+
+void TDMAssignSolver::unplace() {
+    const Placed last = mPlaced.back();
+    mPlaced.pop_back();
+    for (auto &placed : mPlaced) {
+        if ((placed.blockId != last.blockId) || !isOverlapped(placed.source, last.source))
+            continue;
+        for (size_t attr = 0; attr < TDM_ATTR_MAX; attr++) {
+            placed.DPUFAmounts[attr] -= last.source.amounts[attr];
+            if (placed.axiId == last.axiId) placed.AXIAmounts[attr] -= last.source.amounts[attr];
+        }
+    }
+}
+
+bool TDMAssignSolver::isTimedOut() {
+    if (!mTimedOut && ((mNodes % 64) == 0) && (systemTime(SYSTEM_TIME_MONOTONIC) > mDeadline))
+        mTimedOut = true;
+    return mTimedOut || (mNodes > kMaxNodes);
+}
+
+void TDMAssignSolver::search(size_t depth, int32_t count, int32_t rootClass) {
+    mNodes++;
+    if (isTimedOut()) return;
+
+    const int32_t remaining = static_cast<int32_t>(mPending.size() - depth);
+    if (remaining == 0) {
+        if (count > mBestCount) {
+            mBestCount = count;
+            mBestClass = rootClass;
+        }
+        return;
+    }
+
+    uint32_t freeChannels = 0;
+    for (const auto &channelClass : mClasses) freeChannels += channelClass.available;
+    if (count + std::min(remaining, static_cast<int32_t>(freeChannels)) <= mBestCount) return;
+
+    const Source &source = mPending[depth];
+    for (size_t i = 0; i < mClasses.size(); i++) {
+        auto &channelClass = mClasses[i];
+        if ((channelClass.available == 0) || !((channelClass.sources >> depth) & 1)) continue;
+        if (!place(source, channelClass.blockId, channelClass.axiId)) continue;
+        channelClass.available--;
+        search(depth + 1, count + 1, (depth == 0) ? static_cast<int32_t>(i) : rootClass);
+        channelClass.available++;
+        unplace();
+        if (isTimedOut()) return;
+    }
+
+    /* The layer being assigned now should get a channel, others may fall back */
+    if (depth > 0) search(depth + 1, count, rootClass);
+}
+
+int32_t TDMAssignSolver::solve(const std::vector<Channel> &channels, nsecs_t timeBudget) {
+    if (mPending.empty()) return -1;
+
+    mClasses.clear();
+    for (size_t i = 0; i < channels.size(); i++) {
+        const auto &channel = channels[i];
+        if (channel.blockId >= DPU_BLOCK_CNT || channel.axiId >= AXI_PORT_MAX_CNT) continue;
+        uint32_t sources = 0;
+        for (size_t s = 0; s < mPending.size(); s++) {
+            if (isAllowed(mPending[s], channel)) sources |= 1u << s;
+        }
+        /*
+         * Channels the layer being assigned now cannot take are kept for the others,
+         * search() only restricts the root to the classes of source 0
+         */
+        if (sources == 0) continue;
+        bool found = false;
+        for (auto &channelClass : mClasses) {
+            if ((channelClass.blockId == channel.blockId) &&
+                (channelClass.axiId == channel.axiId) && (channelClass.sources == sources)) {
+                channelClass.available++;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            mClasses.push_back(
+                    {channel.blockId, channel.axiId, sources, 1, static_cast<int32_t>(i)});
+    }
+    if (std::none_of(mClasses.begin(), mClasses.end(),
+                     [](const ChannelClass &channelClass) { return channelClass.sources & 1; }))
+        return -1;
+
+    mNodes = 0;
+    mTimedOut = false;
+    mBestCount = -1;
+    mBestClass = -1;
+    mDeadline = systemTime(SYSTEM_TIME_MONOTONIC) + timeBudget;
+    search(0, 0, -1);
+
+    if (mTimedOut || (mNodes > kMaxNodes) || (mBestClass < 0)) return -1;
+    return mClasses[mBestClass].firstChannel;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_ASSIGN_SOLVER_ZUMA_H
+#define _TDM_ASSIGN_SOLVER_ZUMA_H
+
+#include <utils/Timers.h>
+
+#include <array>
+#include <vector>
+
+#include "ExynosHWCModule.h"
+
+namespace zuma {
+
+/*
+ * Branch and bound search of the OTF channel for one layer that keeps the most of the
+ * remaining layers of the display assignable to DPP under the TDM budgets.
+ *
+ * A pending source only goes to the channels of its candidate mask, see
+ * getOtfCandidateMask(), that support YUV if it is YUV. Channels with the same (DPUF, AXI)
+ * allowing the same pending sources are interchangeable, so the search branches on channel
+ * classes instead of channels. Budgets are checked like
+ * checkTDMResource() does: a source is limited by the amounts of every source in the same
+ * DPUF (and AXI port for LS_DPUF_AXI attributes) overlapping its scanline span.
+ */
+class TDMAssignSolver {
+public:
+    using Amounts = std::array<uint32_t, TDM_ATTR_MAX>;
+
+    struct Source {
+        int32_t top;
+        int32_t bottom;
+        /* Span widened by the fetch margin, see getTDMSpan() */
+        int32_t spanTop;
+        int32_t spanBottom;
+        bool yuv;
+        /* Bits of the channels the source can be given to */
+        uint32_t candidates;
+        Amounts amounts;
+    };
+
+    struct Channel {
+        uint32_t blockId;
+        uint32_t axiId;
+        bool yuv;
+        /* Bit of the channel in candidate masks, 0 if it is not indexed */
+        uint32_t candidateBit;
+    };
+
+    /* totalAmounts[blockId][axiId], AXI_DONT_CARE budgets of LS_DPUF attributes are in both */
+    using Budgets = std::array<std::array<Amounts, AXI_PORT_MAX_CNT>, DPU_BLOCK_CNT>;
+
+    static constexpr size_t kMaxSources = 16;
+    static_assert(kMaxSources <= 32, "ChannelClass::sources is a uint32_t");
+    static constexpr size_t kMaxNodes = 20000;
+    static constexpr nsecs_t kDefaultTimeBudget = 300000; /* 300us */
+
+    TDMAssignSolver(const Budgets &budgets, const std::array<bool, TDM_ATTR_MAX> &perAXI)
+          : mBudgets(budgets), mPerAXI(perAXI) {}
+
+    /* Sources already assigned to channels */
+    void addAssigned(const Source &source, uint32_t blockId, uint32_t axiId);
+    /* Sources to be assigned, the first one is the layer being assigned now */
+    void addPending(const Source &source);
+
+    /*
+     * Returns the index into channels of the channel for the first pending source,
+     * or -1 if the search cannot finish in the time budget or the source fits nowhere.
+     * On a tie, the channel appearing first in channels wins.
+     */
+    int32_t solve(const std::vector<Channel> &channels, nsecs_t timeBudget = kDefaultTimeBudget);
+
+    size_t getVisitedNodes() const { return mNodes; }
+    int32_t getBestCount() const { return mBestCount; }
+
+private:
+    struct Placed {
+        Source source;
+        uint32_t blockId;
+        uint32_t axiId;
+        Amounts DPUFAmounts;
+        Amounts AXIAmounts;
+    };
+
+    struct ChannelClass {
+        uint32_t blockId;
+        uint32_t axiId;
+        /* Bit i is set if mPending[i] can be given to the channels */
+        uint32_t sources;
+        uint32_t available;
+        int32_t firstChannel;
+    };
+
+    static bool isAllowed(const Source &source, const Channel &channel) {
+        if (source.yuv && !channel.yuv) return false;
+        return (channel.candidateBit == 0) || (source.candidates & channel.candidateBit);
+    }
+    static bool isOverlapped(const Source &current, const Source &compare) {
+        return (compare.top <= current.spanBottom) && (current.spanTop <= compare.bottom);
+    }
+    bool isOverBudget(const Placed &placed) const;
+    bool place(const Source &source, uint32_t blockId, uint32_t axiId);
+    void unplace();
+    void search(size_t depth, int32_t count, int32_t rootClass);
+    bool isTimedOut();
+
+    const Budgets mBudgets;
+    const std::array<bool, TDM_ATTR_MAX> mPerAXI;
+    std::vector<Placed> mPlaced;
+    std::vector<Source> mPending;
+    std::vector<ChannelClass> mClasses;
+
+    nsecs_t mDeadline = 0;
+    size_t mNodes = 0;
+    bool mTimedOut = false;
+    int32_t mBestCount = -1;
+    int32_t mBestClass = -1;
+};
+
+} // namespace zuma
+
+#endif // _TDM_ASSIGN_SOLVER_ZUMA_H
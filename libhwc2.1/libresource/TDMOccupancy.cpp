@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TDMOccupancy.h"
+
+#include <algorithm>
+
+using namespace zuma;
+
+void TDMOccupancy::clear() {
+    for (auto &block : mBuckets) {
+        for (auto &bucket : block) bucket.count = 0;
+    }
+    mCount = 0;
+    mValid = true;
+    mBuilt = false;
+}
+
+bool TDMOccupancy::add(uint32_t blockId, uint32_t axiId, int32_t top, int32_t bottom,
+                       const Amounts &amounts) {
+    if (blockId >= DPU_BLOCK_CNT || axiId >= AXI_PORT_MAX_CNT || mCount >= kMaxSources) {
+        mValid = false;
+        return false;
+    }
+
+    mRows[mCount] = amounts;
+    mTops[mCount] = top;
+    mBottoms[mCount] = bottom;
+    Bucket &bucket = mBuckets[blockId][axiId];
+    bucket.sources[bucket.count++] = static_cast<uint8_t>(mCount);
+    mCount++;
+    mBuilt = false;
+    return true;
+}
+
+void TDMOccupancy::buildSorted(const Bucket &bucket,
+                               const std::array<int32_t, kMaxSources> &keys,
+                               SortedAmounts &sorted) const {
+    std::array<uint8_t, kMaxSources> order = bucket.sources;
+    std::sort(order.begin(), order.begin() + bucket.count,
+              [&keys](uint8_t l, uint8_t r) { return keys[l] < keys[r]; });
+
+    sorted.prefix[0] = Amounts();
+    sorted.prefixMask[0] = 0;
+    for (size_t i = 0; i < bucket.count; i++) {
+        const uint8_t source = order[i];
+        sorted.keys[i] = keys[source];
+        sorted.prefix[i + 1] = sorted.prefix[i] + mRows[source];
+        sorted.prefixMask[i + 1] = sorted.prefixMask[i] | (1u << source);
+    }
+}
+
+void TDMOccupancy::build() {
+    for (auto &block : mBuckets) {
+        for (auto &bucket : block) {
+            buildSorted(bucket, mTops, bucket.byTop);
+            buildSorted(bucket, mBottoms, bucket.byBottom);
+        }
+    }
+    mBuilt = true;
+}
+
+void TDMOccupancy::queryBucket(const Bucket &bucket, int32_t spanTop, int32_t spanBottom,
+                               Amounts *amounts, uint32_t &mask) {
+    const int32_t *topKeys = bucket.byTop.keys.data();
+    const int32_t *bottomKeys = bucket.byBottom.keys.data();
+    /* sources starting at or before spanBottom */
+    const size_t startedCnt =
+            std::upper_bound(topKeys, topKeys + bucket.count, spanBottom) - topKeys;
+    /* sources ending before spanTop */
+    const size_t endedCnt =
+            std::lower_bound(bottomKeys, bottomKeys + bucket.count, spanTop) - bottomKeys;
+
+    if (amounts) {
+        *amounts += bucket.byTop.prefix[startedCnt];
+        *amounts -= bucket.byBottom.prefix[endedCnt];
+    }
+    mask |= bucket.byTop.prefixMask[startedCnt] & ~bucket.byBottom.prefixMask[endedCnt];
+}
+
+bool TDMOccupancy::query(uint32_t blockId, uint32_t axiId, int32_t spanTop, int32_t spanBottom,
+                         Amounts &DPUFAmounts, Amounts &AXIAmounts) const {
+    if (!isValid() || spanTop > spanBottom || blockId >= DPU_BLOCK_CNT ||
+        axiId >= AXI_PORT_MAX_CNT)
+        return false;
+
+    for (uint32_t axi = 0; axi < AXI_PORT_MAX_CNT; axi++) {
+        Amounts amounts;
+        uint32_t mask = 0;
+        queryBucket(mBuckets[blockId][axi], spanTop, spanBottom, &amounts, mask);
+        DPUFAmounts += amounts;
+        if (axi == axiId) AXIAmounts += amounts;
+    }
+    return true;
+}
+
+bool TDMOccupancy::getOverlapMask(uint32_t blockId, int32_t spanTop, int32_t spanBottom,
+                                  uint32_t &mask) const {
+    if (!isValid() || blockId >= DPU_BLOCK_CNT) return false;
+
+    mask = 0;
+    if (spanTop > spanBottom) return true;
+    for (uint32_t axi = 0; axi < AXI_PORT_MAX_CNT; axi++)
+        queryBucket(mBuckets[blockId][axi], spanTop, spanBottom, nullptr, mask);
+    return true;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_OCCUPANCY_ZUMA_H
+#define _TDM_OCCUPANCY_ZUMA_H
+
+#include <array>
+
+#include "ExynosHWCModule.h"
+#include "TDMAmounts.h"
+
+namespace zuma {
+
+static_assert(TDM_ATTR_MAX <= TDMAmounts::kLanes, "TDM attributes don't fit in TDMAmounts");
+
+/*
+ * Scanline occupancy of the sources that are already assigned to DPP channels of a display.
+ *
+ * Sources are bucketed by (DPUF, AXI) and kept sorted by their top and bottom scanlines with
+ * prefix sums of their TDM amounts, so the accumulated amount of every source overlapping a
+ * scanline span is two binary searches per bucket instead of a walk over all layers of the
+ * display. The prefix sums are TDMAmounts vectors, and next to them are prefix masks of the
+ * sources so the same searches give the set of overlapping sources.
+ *
+ * A source [top, bottom] overlaps the span [spanTop, spanBottom] unless it ends before
+ * spanTop or starts after spanBottom. When spanTop <= spanBottom the sources ending before
+ * spanTop are a subset of the sources starting at or before spanBottom, so
+ *   overlapped = sum(top <= spanBottom) - sum(bottom < spanTop)
+ */
+class TDMOccupancy {
+public:
+    using Amounts = TDMAmounts;
+    /* Width of the source masks, a display never has more DPP channels than this */
+    static constexpr size_t kMaxSources = 32;
+
+    void clear();
+    /*
+     * Sources are numbered in the order they are added, see size().
+     * Returns false if the source cannot be indexed, the occupancy becomes unusable.
+     */
+    bool add(uint32_t blockId, uint32_t axiId, int32_t top, int32_t bottom,
+             const Amounts &amounts);
+    /* Sort buckets and build prefix sums, should be called after the last add() */
+    void build();
+    bool isValid() const { return mValid && mBuilt; }
+    size_t size() const { return mCount; }
+
+    /*
+     * Accumulate amounts of the sources overlapping [spanTop, spanBottom] into
+     * DPUFAmounts (every source in blockId) and AXIAmounts (sources in blockId and axiId).
+     * Returns false if the span cannot be answered from the index.
+     */
+    bool query(uint32_t blockId, uint32_t axiId, int32_t spanTop, int32_t spanBottom,
+               Amounts &DPUFAmounts, Amounts &AXIAmounts) const;
+    /* Bit i of mask is set if the i-th added source is in blockId and overlaps the span */
+    bool getOverlapMask(uint32_t blockId, int32_t spanTop, int32_t spanBottom,
+                        uint32_t &mask) const;
+
+private:
+    struct SortedAmounts {
+        std::array<int32_t, kMaxSources> keys;
+        /* prefix[i] and prefixMask[i] cover the first i sources, prefix[0] is zero */
+        std::array<Amounts, kMaxSources + 1> prefix;
+        std::array<uint32_t, kMaxSources + 1> prefixMask;
+    };
+
+    struct Bucket {
+        std::array<uint8_t, kMaxSources> sources;
+        size_t count = 0;
+        SortedAmounts byTop;
+        SortedAmounts byBottom;
+    };
+
+    void buildSorted(const Bucket &bucket, const std::array<int32_t, kMaxSources> &keys,
+                     SortedAmounts &sorted) const;
+    static void queryBucket(const Bucket &bucket, int32_t spanTop, int32_t spanBottom,
+                            Amounts *amounts, uint32_t &mask);
+
+    std::array<Amounts, kMaxSources> mRows;
+    std::array<int32_t, kMaxSources> mTops;
+    std::array<int32_t, kMaxSources> mBottoms;
+    Bucket mBuckets[DPU_BLOCK_CNT][AXI_PORT_MAX_CNT];
+    size_t mCount = 0;
+    bool mValid = false;
+    bool mBuilt = false;
+};
+
+} // namespace zuma
+
+#endif // _TDM_OCCUPANCY_ZUMA_H
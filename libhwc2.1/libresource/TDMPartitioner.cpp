@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TDMPartitioner.h"
+
+#include <algorithm>
+
+namespace zuma {
+
+/* Raise amounts towards targets by equal shares until targets are met or remaining runs out */
+static void fillFairly(const std::vector<uint32_t> &targets, std::vector<uint32_t> &amounts,
+                       uint32_t &remaining) {
+    const size_t count = targets.size();
+    while (remaining > 0) {
+        size_t unsatisfied = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (amounts[i] < targets[i]) unsatisfied++;
+        }
+        if (unsatisfied == 0) break;
+
+        const uint32_t share = std::max<uint32_t>(remaining / unsatisfied, 1);
+        for (size_t i = 0; (i < count) && (remaining > 0); i++) {
+            if (amounts[i] >= targets[i]) continue;
+            const uint32_t amount = std::min({share, targets[i] - amounts[i], remaining});
+            amounts[i] += amount;
+            remaining -= amount;
+        }
+    }
+}
+
+std::vector<uint32_t> partitionTDMResource(uint32_t total,
+                                           const std::vector<TDMResourceRequest> &requests) {
+    const size_t count = requests.size();
+    std::vector<uint32_t> amounts(count, 0);
+    if (count == 0) return amounts;
+
+    std::vector<uint32_t> reserves(count, 0);
+    for (size_t i = 0; i < count; i++)
+        reserves[i] = std::min(requests[i].reserve, requests[i].cap);
+
+    uint32_t remaining = total;
+    fillFairly(reserves, amounts, remaining);
+
+    /* Leftover in priority order */
+    for (size_t i = 0; (i < count) && (remaining > 0); i++) {
+        if (amounts[i] >= requests[i].cap) continue;
+        const uint32_t amount = std::min(requests[i].cap - amounts[i], remaining);
+        amounts[i] += amount;
+        remaining -= amount;
+    }
+
+    return amounts;
+}
+
+} // namespace zuma
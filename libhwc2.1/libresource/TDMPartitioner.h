@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_PARTITIONER_ZUMA_H
+#define _TDM_PARTITIONER_ZUMA_H
+
+#include <cstdint>
+#include <vector>
+
+namespace zuma {
+
+/*
+ * Split of one HW resource (an attribute of a DPUF, or of a DPUF and AXI port)
+ * between the enabled displays.
+ */
+struct TDMResourceRequest {
+    /* Amount set aside for the display while it is enabled */
+    uint32_t reserve;
+    /* Most the display can use, maxAssignedAmount of its display type */
+    uint32_t cap;
+};
+
+/*
+ * Requests are in priority order. Every request is first given its reserve, up to its cap,
+ * split max-min fairly if the total is not enough. What is left goes to the requests in
+ * priority order, up to their cap.
+ * The result only depends on the static amounts of the requests, and its sum never
+ * exceeds total.
+ */
+std::vector<uint32_t> partitionTDMResource(uint32_t total,
+                                           const std::vector<TDMResourceRequest> &requests);
+
+} // namespace zuma
+
+#endif // _TDM_PARTITIONER_ZUMA_H
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_REJECTION_LOG_ZUMA_H
+#define _TDM_REJECTION_LOG_ZUMA_H
+
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#include "ExynosHWCModule.h"
+
+namespace zuma {
+
+/*
+ * Last rejections of checkTDMResource(), kept as fixed-size binary records and only
+ * formatted by dump(), so it stays on without eDebugTDM.
+ *
+ * record() is only called on the validate thread and takes no lock: it fills the slot of the
+ * next index under a per-slot sequence number, then publishes the index. dump() reads the
+ * slots like a seqlock and skips a record overwritten while it was copied.
+ * Names are copied into the record, truncated to kNameSize - 1 characters.
+ */
+class TDMRejectionLog {
+public:
+    static constexpr size_t kSize = 64;
+    static constexpr size_t kNameSize = 24;
+
+    struct Event {
+        nsecs_t timestamp;
+        /* Source being checked, its buffer handle for matching with layer dumps */
+        const void *source;
+        const void *bufferHandle;
+        char displayName[kNameSize];
+        char mppName[kNameSize];
+        uint32_t attr;
+        uint32_t blockId;
+        /* AXI_DONT_CARE for LS_DPUF attributes */
+        uint32_t axiId;
+        uint32_t accumulated;
+        uint32_t current;
+        uint32_t total;
+    };
+
+    static void setName(char (&dst)[kNameSize], const char *name) {
+        strncpy(dst, name ? name : "", kNameSize - 1);
+        dst[kNameSize - 1] = '\0';
+    }
+
+    /* name should outlive this, it is used for dump */
+    void setAttrName(uint32_t attr, const char *name) {
+        if (attr < TDM_ATTR_MAX) mAttrNames[attr] = name;
+    }
+
+    void record(const Event &event) {
+        const uint64_t index = mCount.load(std::memory_order_relaxed);
+        Slot &slot = mSlots[index % kSize];
+        uint64_t words[kWords];
+        memcpy(words, &event, sizeof(event));
+
+        /* Odd while the slot is written, 2 * (index + 1) once it holds record index */
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; i++)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.seq.store(2 * (index + 1), std::memory_order_release);
+        mCount.store(index + 1, std::memory_order_release);
+    }
+
+    void dump(String8 &result) const {
+        const uint64_t count = mCount.load(std::memory_order_acquire);
+        result.appendFormat("TDM rejections (last %zu of %" PRIu64 ")\n",
+                            static_cast<size_t>(std::min<uint64_t>(count, kSize)), count);
+        const uint64_t first = (count > kSize) ? count - kSize : 0;
+        for (uint64_t i = first; i < count; i++) {
+            Event event;
+            if (!read(i, event)) continue;
+            result.appendFormat("\t%" PRId64 " [%s] src %p(handle %p) -> %s, DPUF%u",
+                                event.timestamp, event.displayName, event.source,
+                                event.bufferHandle, event.mppName, event.blockId);
+            if (event.axiId != AXI_DONT_CARE) result.appendFormat(",AXI%u", event.axiId);
+            result.appendFormat(" %s: accumulated %u + current %u > total %u\n",
+                                getAttrName(event.attr), event.accumulated, event.current,
+                                event.total);
+        }
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(Event) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::array<std::atomic<uint64_t>, kWords> words{};
+    };
+
+    /* False if record index is not in its slot, it was overwritten or is being written */
+    bool read(uint64_t index, Event &event) const {
+        const Slot &slot = mSlots[index % kSize];
+        const uint64_t expected = 2 * (index + 1);
+        if (slot.seq.load(std::memory_order_acquire) != expected) return false;
+        uint64_t words[kWords];
+        for (size_t i = 0; i < kWords; i++)
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != expected) return false;
+        memcpy(&event, words, sizeof(event));
+        return true;
+    }
+
+    const char *getAttrName(uint32_t attr) const {
+        return ((attr < TDM_ATTR_MAX) && mAttrNames[attr]) ? mAttrNames[attr] : "unknown";
+    }
+
+    std::array<const char *, TDM_ATTR_MAX> mAttrNames{};
+    std::array<Slot, kSize> mSlots;
+    std::atomic<uint64_t> mCount{0};
+};
+
+} // namespace zuma
+
+#endif // _TDM_REJECTION_LOG_ZUMA_H
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_STATS_ZUMA_H
+#define _TDM_STATS_ZUMA_H
+
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+#include <array>
+#include <atomic>
+
+#include "ExynosHWCModule.h"
+
+namespace zuma {
+
+/*
+ * Cost and result counters of TDM based assignment.
+ * Updated on the validate path and read by dumpsys, so every counter is a relaxed atomic.
+ */
+class TDMStats {
+public:
+    class Counter {
+    public:
+        void add(uint64_t value = 1) { mValue.fetch_add(value, std::memory_order_relaxed); }
+        void max(uint64_t value) {
+            uint64_t cur = mValue.load(std::memory_order_relaxed);
+            while (cur < value &&
+                   !mValue.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+            }
+        }
+        uint64_t get() const { return mValue.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> mValue{0};
+    };
+
+    /* Latency, pass rate and incremental share of a resource manager call */
+    struct CallStats {
+        Counter count;
+        Counter passed;
+        /* Calls that only redid part of their work */
+        Counter incremental;
+        Counter totalNs;
+        Counter maxNs;
+
+        void record(nsecs_t duration, bool pass, bool partial) {
+            count.add();
+            if (pass) passed.add();
+            if (partial) incremental.add();
+            totalNs.add(duration);
+            maxNs.max(duration);
+        }
+    };
+
+    /* isHWResourceAvailable(), passed means the candidate MPP can be assigned */
+    CallStats availability;
+    /* otfMppReordering() */
+    CallStats reordering;
+    /* TDMAssignSolver, passed means it finished in the time budget */
+    CallStats solver;
+    /* setDisplaysTDMInfo(), incremental means only part of the budgets were split again */
+    CallStats budgetUpdate;
+    /* initDisplaysTDMInfo() */
+    CallStats budgetInit;
+    /* (attr, DPUF, AXI) entries split by setDisplaysTDMInfo() */
+    Counter budgetEntries;
+    /* Attribute that rejected the candidate MPP in checkTDMResource() */
+    std::array<Counter, TDM_ATTR_MAX> rejectedBy;
+    /* isHWResourceAvailable() answered from a previous frame */
+    Counter reusedDecisions;
+    /* checkTDMResource() answered by a previous rejection, or checked */
+    Counter rejectionCacheHits;
+    Counter rejectionCacheMisses;
+    /* Layers left to greedy ordering as the solver time of the frame was used up */
+    Counter solverSkipped;
+    /* isHWResourceAvailable() of channels the layer's candidate mask excludes */
+    Counter filteredCandidates;
+    /* otfMppReordering() that packed onto PACKING_BLOCK or spread the layer */
+    Counter packedReorderings;
+    Counter spreadReorderings;
+    /* Presents sampled with windows clipped to their partial update region */
+    Counter partialUpdatePresents;
+
+    static void dumpCallStats(String8 &result, const char *name, const CallStats &stats) {
+        const uint64_t count = stats.count.get();
+        result.appendFormat("\t%-24s calls %" PRIu64 ", passed %" PRIu64
+                            ", incremental %" PRIu64 ", avg %" PRIu64 " ns, max %" PRIu64
+                            " ns\n",
+                            name, count, stats.passed.get(), stats.incremental.get(),
+                            count ? stats.totalNs.get() / count : 0, stats.maxNs.get());
+    }
+};
+
+/*
+ * Records the duration of the enclosing scope into TDMStats::CallStats.
+ * Nothing is read or recorded unless enabled, the scopes are on the validate path.
+ */
+class TDMStatsScope {
+public:
+    TDMStatsScope(TDMStats::CallStats &stats, bool enabled)
+          : mStats(enabled ? &stats : nullptr),
+            mStart(enabled ? systemTime(SYSTEM_TIME_MONOTONIC) : 0) {}
+    ~TDMStatsScope() {
+        if (mStats)
+            mStats->record(systemTime(SYSTEM_TIME_MONOTONIC) - mStart, mPassed, mIncremental);
+    }
+    void setPassed(bool passed) { mPassed = passed; }
+    void setIncremental(bool incremental) { mIncremental = incremental; }
+
+private:
+    TDMStats::CallStats *const mStats;
+    const nsecs_t mStart;
+    bool mPassed = true;
+    bool mIncremental = false;
+};
+
+} // namespace zuma
+
+#endif // _TDM_STATS_ZUMA_H
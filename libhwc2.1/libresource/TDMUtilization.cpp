@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_GRAPHICS | ATRACE_TAG_HAL)
+
+#include "TDMUtilization.h"
+
+#include <utils/Trace.h>
+
+#include <algorithm>
+
+using namespace zuma;
+
+void TDMUtilization::sample(uint32_t displaySlot, uint32_t attr, uint32_t blockId,
+                            uint32_t axiId, uint32_t used, uint32_t total) {
+    if ((displaySlot >= kMaxDisplays) || (attr >= TDM_ATTR_MAX) || (blockId >= DPU_BLOCK_CNT) ||
+        (total == 0))
+        return;
+    const uint32_t axiSlot = (axiId == AXI_DONT_CARE) ? static_cast<uint32_t>(AXI_PORT_MAX_CNT) : axiId;
+    if (axiSlot >= HW_RESOURCE_AXI_SLOT_CNT) return;
+
+    Display &display = mDisplays[displaySlot];
+    const uint8_t percent = static_cast<uint8_t>(std::min(used * 100 / total, 100u));
+    uint8_t &peak = display.framePeaks[getSlot(attr, blockId, axiSlot)];
+    if (peak == kNoSample || peak < percent) peak = percent;
+    display.hasSamples = true;
+}
+
+void TDMUtilization::buildTraceNames(Display &display, const char *displayName) const {
+    for (uint32_t slot = 0; slot < kSlotCnt; slot++) {
+        const uint32_t axiSlot = slot % HW_RESOURCE_AXI_SLOT_CNT;
+        const uint32_t blockId = (slot / HW_RESOURCE_AXI_SLOT_CNT) % DPU_BLOCK_CNT;
+        const uint32_t attr = slot / (HW_RESOURCE_AXI_SLOT_CNT * DPU_BLOCK_CNT);
+        String8 &name = display.traceNames[slot];
+        name.clear();
+        name.appendFormat("TDM %s %s DPUF%u", displayName, getAttrName(attr), blockId);
+        if (axiSlot != AXI_PORT_MAX_CNT) name.appendFormat(" AXI%u", axiSlot);
+    }
+    display.hasTraceNames = true;
+}
+
+void TDMUtilization::endFrame(uint32_t displaySlot, const char *displayName) {
+    if (displaySlot >= kMaxDisplays) return;
+
+    Display &display = mDisplays[displaySlot];
+    if (!display.hasSamples) return;
+
+    const bool tracing = ATRACE_ENABLED();
+    if (tracing && !display.hasTraceNames) buildTraceNames(display, displayName);
+    for (uint32_t slot = 0; slot < kSlotCnt; slot++) {
+        const uint8_t percent = display.framePeaks[slot];
+        if (percent == kNoSample) continue;
+
+        Histogram &histogram = display.histograms[slot];
+        histogram.buckets[std::min(percent / 10u, kBucketCnt - 1)].fetch_add(
+                1, std::memory_order_relaxed);
+        uint32_t peak = histogram.peak.load(std::memory_order_relaxed);
+        while (peak < percent &&
+               !histogram.peak.compare_exchange_weak(peak, percent, std::memory_order_relaxed)) {
+        }
+
+        if (tracing) ATRACE_INT(display.traceNames[slot].c_str(), percent);
+    }
+
+    display.framePeaks.fill(kNoSample);
+    display.hasSamples = false;
+    display.frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t TDMUtilization::Histogram::getPercentile(uint64_t frames, uint32_t percent) const {
+    uint64_t count = 0;
+    for (uint32_t bucket = 0; bucket < kBucketCnt; bucket++) {
+        count += buckets[bucket].load(std::memory_order_relaxed);
+        if (count * 100 >= frames * percent)
+            return std::min({(bucket + 1) * 10, 100u, peak.load(std::memory_order_relaxed)});
+    }
+    return peak.load(std::memory_order_relaxed);
+}
+
+void TDMUtilization::dump(String8 &result, uint32_t displaySlot,
+                          const char *displayName) const {
+    if (displaySlot >= kMaxDisplays) return;
+
+    const Display &display = mDisplays[displaySlot];
+    const uint64_t frames = display.frames.load(std::memory_order_relaxed);
+    if (frames == 0) return;
+
+    result.appendFormat("\t%s : %" PRIu64 " frames, peak usage %% of budget (p50/p90/p99/max)\n",
+                        displayName, frames);
+    for (uint32_t slot = 0; slot < kSlotCnt; slot++) {
+        const Histogram &histogram = display.histograms[slot];
+        uint64_t sampled = 0;
+        for (const auto &bucket : histogram.buckets)
+            sampled += bucket.load(std::memory_order_relaxed);
+        if (sampled == 0) continue;
+
+        const uint32_t axiSlot = slot % HW_RESOURCE_AXI_SLOT_CNT;
+        const uint32_t blockId = (slot / HW_RESOURCE_AXI_SLOT_CNT) % DPU_BLOCK_CNT;
+        const uint32_t attr = slot / (HW_RESOURCE_AXI_SLOT_CNT * DPU_BLOCK_CNT);
+        result.appendFormat("\t\t%-12s DPUF%u", getAttrName(attr), blockId);
+        if (axiSlot != AXI_PORT_MAX_CNT)
+            result.appendFormat(",AXI%u", axiSlot);
+        else
+            result.appendFormat("     ");
+        result.appendFormat(" : %3u/%3u/%3u/%3u (%" PRIu64 " frames)\n",
+                            histogram.getPercentile(sampled, 50),
+                            histogram.getPercentile(sampled, 90),
+                            histogram.getPercentile(sampled, 99),
+                            histogram.peak.load(std::memory_order_relaxed), sampled);
+    }
+}
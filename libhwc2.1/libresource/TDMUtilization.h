@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_UTILIZATION_ZUMA_H
+#define _TDM_UTILIZATION_ZUMA_H
+
+#include <utils/String8.h>
+
+#include <array>
+#include <atomic>
+
+#include "ExynosHWCModule.h"
+
+namespace zuma {
+
+/*
+ * Per-frame peak usage of each TDM budget, as a percentage of the display's total amount of
+ * a (attribute, DPUF, AXI port) budget. LS_DPUF attributes use the AXI_DONT_CARE slot.
+ *
+ * Peaks of a frame are sampled from its final assignment when it is presented, then
+ * endFrame() moves them to the histograms and to the trace counters.
+ * Histograms are relaxed atomics so that dumpsys can read them from another thread.
+ */
+class TDMUtilization {
+public:
+    static constexpr uint32_t kMaxDisplays = 4;
+    /* 10% steps, the last bucket is a full budget */
+    static constexpr uint32_t kBucketCnt = 11;
+
+    /* name should outlive this, it is used for dump and trace counters */
+    void setAttrName(uint32_t attr, const char *name) {
+        if (attr < TDM_ATTR_MAX) mAttrNames[attr] = name;
+    }
+    /* used is the amount at the busiest scanline of the budget in the frame being presented */
+    void sample(uint32_t displaySlot, uint32_t attr, uint32_t blockId, uint32_t axiId,
+                uint32_t used, uint32_t total);
+    /* Called when the frame of the samples is presented */
+    void endFrame(uint32_t displaySlot, const char *displayName);
+    void dump(String8 &result, uint32_t displaySlot, const char *displayName) const;
+
+private:
+    static constexpr uint32_t kSlotCnt = TDM_ATTR_MAX * DPU_BLOCK_CNT * HW_RESOURCE_AXI_SLOT_CNT;
+    static constexpr uint8_t kNoSample = UINT8_MAX;
+
+    static uint32_t getSlot(uint32_t attr, uint32_t blockId, uint32_t axiSlot) {
+        return (attr * DPU_BLOCK_CNT + blockId) * HW_RESOURCE_AXI_SLOT_CNT + axiSlot;
+    }
+
+    struct Histogram {
+        std::array<std::atomic<uint64_t>, kBucketCnt> buckets{};
+        std::atomic<uint32_t> peak{0};
+
+        /* Upper bound of the bucket reaching the given share of the frames, at most peak */
+        uint32_t getPercentile(uint64_t frames, uint32_t percent) const;
+    };
+
+    struct Display {
+        /* Owned by the present thread */
+        std::array<uint8_t, kSlotCnt> framePeaks;
+        bool hasSamples = false;
+        /* Trace counter of each slot, built at the first traced frame */
+        std::array<String8, kSlotCnt> traceNames;
+        bool hasTraceNames = false;
+
+        std::atomic<uint64_t> frames{0};
+        std::array<Histogram, kSlotCnt> histograms;
+
+        Display() { framePeaks.fill(kNoSample); }
+    };
+
+    void buildTraceNames(Display &display, const char *displayName) const;
+    const char *getAttrName(uint32_t attr) const {
+        return mAttrNames[attr] ? mAttrNames[attr] : "unknown";
+    }
+
+    std::array<const char *, TDM_ATTR_MAX> mAttrNames{};
+    std::array<Display, kMaxDisplays> mDisplays;
+};
+
+} // namespace zuma
+
+#endif // _TDM_UTILIZATION_ZUMA_H
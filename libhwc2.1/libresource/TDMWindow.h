@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TDM_WINDOW_ZUMA_H
+#define _TDM_WINDOW_ZUMA_H
+
+#include <cstdint>
+
+namespace zuma {
+
+/*
+ * Scanlines [top, bottom] a DPP channel is busy with a source of destination lines
+ * [dstY, dstY + dstH]: from topMargin lines before the first destination line, when it starts
+ * fetching, to bottomMargin lines after the last one, clipped to the display.
+ *
+ * A channel only reads ahead of the scanout. It fetches source lines before the destination
+ * lines they are scaled, rotated or decompressed into, and drops them once their last
+ * destination line is out, so nothing of a source is read below its destination. Its
+ * window is padded by its fetch margin at the top only. Two sources then share scanlines
+ * exactly when the lower one starts fetching before the upper one is scanned out, so the
+ * relation stays symmetric: the gap between them has to be within the lead of the lower one.
+ */
+inline void getTDMWindowLines(int32_t dstY, int32_t dstH, uint32_t topMargin,
+                              uint32_t bottomMargin, int32_t yres, int32_t &top,
+                              int32_t &bottom) {
+    top = dstY - static_cast<int32_t>(topMargin);
+    top = (top < 0) ? 0 : top;
+    bottom = dstY + dstH + static_cast<int32_t>(bottomMargin);
+    bottom = (bottom > yres) ? yres : bottom;
+}
+
+inline bool isTDMWindowOverlapped(int32_t top, int32_t bottom, int32_t compareTop,
+                                  int32_t compareBottom) {
+    return (compareTop <= bottom) && (top <= compareBottom);
+}
+
+/*
+ * TDM_OVERLAP_MARGIN is the margin every source used to be padded by, in both directions.
+ * It stays the default.
+ *
+ * The fetch margin model below is opt-in, see vendor.display.tdm.fixed_overlap_margin.
+ * A channel reads its source ahead of the destination lines being scanned out and is done
+ * with it after them. Its line counts are estimates from the buffer layouts, not from the
+ * DPU specification: a rotated source fills a rotation buffer of TDM_ROT_BUFFER_LINES
+ * source lines, an AFBC or SBWC source is read one compression block ahead, a scaled one
+ * by its scaler taps, plus the pipeline depth. Lead lines are source lines, so they shrink
+ * with downscaling and grow with upscaling, and the margin never exceeds the fixed one.
+ */
+constexpr uint32_t TDM_OVERLAP_MARGIN = 68;
+constexpr uint32_t TDM_PIPELINE_LINES = 4;
+constexpr uint32_t TDM_ROT_BUFFER_LINES = 64;
+constexpr uint32_t TDM_AFBC_BLOCK_LINES = 16;
+constexpr uint32_t TDM_SBWC_BLOCK_LINES = 4;
+constexpr uint32_t TDM_SCALER_LEAD_LINES = 4;
+
+/* srcLines are the source lines scaled to dstLines, the source width if it is rotated */
+constexpr uint32_t getTDMFetchMargin(uint32_t srcLines, uint32_t dstLines, bool rot90,
+                                     bool afbc, bool sbwc) {
+    if (srcLines == 0) return TDM_OVERLAP_MARGIN;
+
+    uint32_t leadLines = 0;
+    if (rot90)
+        leadLines = TDM_ROT_BUFFER_LINES;
+    else if (afbc)
+        leadLines = TDM_AFBC_BLOCK_LINES;
+    else if (sbwc)
+        leadLines = TDM_SBWC_BLOCK_LINES;
+    if ((srcLines != dstLines) && (leadLines < TDM_SCALER_LEAD_LINES))
+        leadLines = TDM_SCALER_LEAD_LINES;
+
+    const uint64_t dstLeadLines =
+            (static_cast<uint64_t>(leadLines) * dstLines + srcLines - 1) / srcLines;
+    const uint64_t margin = TDM_PIPELINE_LINES + dstLeadLines;
+    return (margin < TDM_OVERLAP_MARGIN) ? static_cast<uint32_t>(margin) : TDM_OVERLAP_MARGIN;
+}
+
+} // namespace zuma
+
+#endif // _TDM_WINDOW_ZUMA_H
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "LutPacker.h"
+
+using namespace gs;
+
+namespace {
+
+struct Pair32 {
+    uint32_t even;
+    uint32_t odd;
+};
+
+std::vector<uint16_t> makePoints(size_t count) {
+    std::vector<uint16_t> points(count);
+    for (size_t i = 0; i < count; i++) points[i] = static_cast<uint16_t>(i * 2654435761u);
+    return points;
+}
+
+/* The loops the packers replaced, kept out of line so they are not folded into the caller */
+__attribute__((noinline)) void scalarEvenOdd(Pair32 *dst, size_t dstLen, const uint16_t *src) {
+    for (size_t i = 0; i < dstLen; i++) {
+        dst[i].even = src[2 * i];
+        dst[i].odd = src[2 * i + 1];
+    }
+}
+
+__attribute__((noinline)) void scalarColorLut(struct drm_color_lut *dst, size_t len,
+                                              const uint16_t *red, const uint16_t *green,
+                                              const uint16_t *blue) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i].red = red[i];
+        dst[i].green = green[i];
+        dst[i].blue = blue[i];
+    }
+}
+
+void BM_EvenOddScalar(benchmark::State &state) {
+    const size_t len = state.range(0);
+    const auto src = makePoints(2 * len);
+    std::vector<Pair32> dst(len);
+    for (auto _ : state) {
+        scalarEvenOdd(dst.data(), len, src.data());
+        benchmark::ClobberMemory();
+    }
+}
+
+void BM_EvenOddPacker(benchmark::State &state) {
+    const size_t len = state.range(0);
+    const auto src = makePoints(2 * len);
+    std::vector<Pair32> dst(len);
+    for (auto _ : state) {
+        packEvenOdd(dst.data(), len, src.data(), src.size());
+        benchmark::ClobberMemory();
+    }
+}
+
+void BM_ColorLutScalar(benchmark::State &state) {
+    const size_t len = state.range(0);
+    const auto red = makePoints(len), green = makePoints(len), blue = makePoints(len);
+    std::vector<struct drm_color_lut> dst(len);
+    for (auto _ : state) {
+        scalarColorLut(dst.data(), len, red.data(), green.data(), blue.data());
+        benchmark::ClobberMemory();
+    }
+}
+
+void BM_ColorLutPacker(benchmark::State &state) {
+    const size_t len = state.range(0);
+    const auto red = makePoints(len), green = makePoints(len), blue = makePoints(len);
+    std::vector<struct drm_color_lut> dst(len);
+    for (auto _ : state) {
+        packColorLut(dst.data(), len, red.data(), green.data(), blue.data());
+        benchmark::ClobberMemory();
+    }
+}
+
+} // namespace
+
+/* Around the HDR transfer function LUTs */
+BENCHMARK(BM_EvenOddScalar)->Arg(20)->Arg(33)->Arg(64);
+BENCHMARK(BM_EvenOddPacker)->Arg(20)->Arg(33)->Arg(64);
+/* Around the DQE degamma and regamma LUTs */
+BENCHMARK(BM_ColorLutScalar)->Arg(65)->Arg(256)->Arg(1024);
+BENCHMARK(BM_ColorLutPacker)->Arg(65)->Arg(256)->Arg(1024);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "LutPacker.h"
+
+using namespace gs;
+
+namespace {
+
+/* Layouts of the samsung_drm even/odd LUTs: copied, widened and filled pair by pair */
+struct Pair16 {
+    uint16_t even;
+    uint16_t odd;
+};
+struct Pair32 {
+    uint32_t even;
+    uint32_t odd;
+};
+struct PairSplit {
+    uint32_t even;
+    uint16_t pad;
+    uint32_t odd;
+};
+
+/* Lengths around the 8 points a NEON iteration packs */
+constexpr size_t kLengths[] = {1, 3, 4, 5, 8, 9, 16, 17, 20, 33, 64, 65};
+constexpr uint8_t kPoison = 0xa5;
+
+std::vector<uint16_t> makePoints(size_t count) {
+    std::vector<uint16_t> points(count);
+    for (size_t i = 0; i < count; i++)
+        points[i] = static_cast<uint16_t>(0x8000 ^ (i * 2654435761u));
+    return points;
+}
+
+/* The element by element loop the packer replaced, with missing points as 0 */
+template <typename Pair>
+void referenceEvenOdd(Pair *dst, size_t dstLen, const uint16_t *src, size_t srcLen) {
+    for (size_t i = 0; i < dstLen; i++) {
+        dst[i].even = (2 * i < srcLen) ? src[2 * i] : 0;
+        dst[i].odd = (2 * i + 1 < srcLen) ? src[2 * i + 1] : 0;
+    }
+}
+
+template <typename Pair>
+void checkEvenOdd(size_t dstLen, size_t srcLen) {
+    const auto src = makePoints(srcLen);
+    std::vector<Pair> expected(dstLen), packed(dstLen);
+    /* Padding is compared too, so both start from the same bytes */
+    memset(expected.data(), kPoison, dstLen * sizeof(Pair));
+    memset(packed.data(), kPoison, dstLen * sizeof(Pair));
+
+    referenceEvenOdd(expected.data(), dstLen, src.data(), srcLen);
+    packEvenOdd(packed.data(), dstLen, src.data(), srcLen);
+    EXPECT_EQ(0, memcmp(expected.data(), packed.data(), dstLen * sizeof(Pair)))
+            << "dstLen " << dstLen << " srcLen " << srcLen;
+}
+
+template <typename Pair>
+void checkEvenOddLengths() {
+    for (const size_t len : kLengths) {
+        /* Full (DTM, OETF), one point short (EOTF), shorter and longer sources */
+        checkEvenOdd<Pair>(len, 2 * len);
+        checkEvenOdd<Pair>(len, 2 * len - 1);
+        checkEvenOdd<Pair>(len, len);
+        checkEvenOdd<Pair>(len, 2 * len + 3);
+        checkEvenOdd<Pair>(len, 0);
+    }
+}
+
+void referenceColorLut(struct drm_color_lut *dst, size_t len, const uint16_t *red,
+                       const uint16_t *green, const uint16_t *blue) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i].red = red ? red[i] : 0;
+        dst[i].green = green ? green[i] : 0;
+        dst[i].blue = blue ? blue[i] : 0;
+        dst[i].reserved = 0;
+    }
+}
+
+} // namespace
+
+TEST(LutPackerTest, EvenOddCopiesPairsOfSourceWidth) {
+    checkEvenOddLengths<Pair16>();
+}
+
+TEST(LutPackerTest, EvenOddWidensContiguousPairs) {
+    checkEvenOddLengths<Pair32>();
+}
+
+TEST(LutPackerTest, EvenOddFillsOtherLayoutsPairByPair) {
+    checkEvenOddLengths<PairSplit>();
+}
+
+TEST(LutPackerTest, EvenOddLeavesMissingLastOddPointZero) {
+    /* EOTF has one point fewer than its LUT holds */
+    constexpr size_t kLen = 20;
+    const auto src = makePoints(2 * kLen - 1);
+    Pair32 packed[kLen];
+    memset(packed, kPoison, sizeof(packed));
+
+    packEvenOdd(packed, kLen, src.data(), src.size());
+    EXPECT_EQ(src[2 * kLen - 2], packed[kLen - 1].even);
+    EXPECT_EQ(0u, packed[kLen - 1].odd);
+}
+
+TEST(LutPackerTest, ColorLutMatchesChannelLoop) {
+    for (const size_t len : kLengths) {
+        const auto red = makePoints(len);
+        const auto green = makePoints(len + 1);
+        const auto blue = makePoints(len + 2);
+        const uint16_t *channels[][3] = {
+                {red.data(), green.data(), blue.data()},
+                {red.data(), nullptr, nullptr},
+                {nullptr, green.data(), nullptr},
+                {nullptr, nullptr, nullptr},
+        };
+        for (const auto &rgb : channels) {
+            std::vector<struct drm_color_lut> expected(len), packed(len);
+            memset(expected.data(), kPoison, len * sizeof(struct drm_color_lut));
+            memset(packed.data(), kPoison, len * sizeof(struct drm_color_lut));
+
+            referenceColorLut(expected.data(), len, rgb[0], rgb[1], rgb[2]);
+            packColorLut(packed.data(), len, rgb[0], rgb[1], rgb[2]);
+            EXPECT_EQ(0, memcmp(expected.data(), packed.data(),
+                                len * sizeof(struct drm_color_lut)))
+                    << "len " << len;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "TDMAmounts.h"
+
+using namespace zuma;
+
+namespace {
+
+using Lanes = uint32_t[TDMAmounts::kLanes];
+
+std::vector<TDMAmounts> makeSources(size_t count) {
+    std::vector<TDMAmounts> sources(count);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t lane = 0; lane < TDMAmounts::kLanes; lane++)
+            sources[i][lane] = static_cast<uint32_t>((i * 2654435761u + lane) & 0x1f);
+    }
+    return sources;
+}
+
+/* The per-attribute loops TDMAmounts replaced, kept out of line so they are not folded */
+__attribute__((noinline)) uint32_t scalarAccumulate(const std::vector<TDMAmounts> &sources,
+                                                    const Lanes &budget) {
+    Lanes sum = {};
+    uint32_t exceeded = 0;
+    for (const auto &source : sources) {
+        for (size_t lane = 0; lane < TDMAmounts::kLanes; lane++) {
+            sum[lane] += source[lane];
+            if (sum[lane] > budget[lane]) exceeded |= 1u << lane;
+        }
+    }
+    return exceeded;
+}
+
+__attribute__((noinline)) uint32_t vectorAccumulate(const std::vector<TDMAmounts> &sources,
+                                                    const TDMAmounts &budget) {
+    TDMAmounts sum;
+    uint32_t exceeded = 0;
+    for (const auto &source : sources) {
+        sum += source;
+        exceeded |= sum.greaterThan(budget);
+    }
+    return exceeded;
+}
+
+void BM_AccumulateScalar(benchmark::State &state) {
+    const auto sources = makeSources(state.range(0));
+    Lanes budget;
+    for (auto &lane : budget) lane = 100;
+    for (auto _ : state) benchmark::DoNotOptimize(scalarAccumulate(sources, budget));
+}
+
+void BM_AccumulateVector(benchmark::State &state) {
+    const auto sources = makeSources(state.range(0));
+    TDMAmounts budget;
+    for (size_t lane = 0; lane < TDMAmounts::kLanes; lane++) budget[lane] = 100;
+    for (auto _ : state) benchmark::DoNotOptimize(vectorAccumulate(sources, budget));
+}
+
+} // namespace
+
+/* Sources overlapping a checked span, up to every DPP channel of a DPUF */
+BENCHMARK(BM_AccumulateScalar)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_AccumulateVector)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "TDMWindow.h"
+
+using namespace zuma;
+
+namespace {
+
+constexpr int32_t kYres = 2400;
+
+/* Source of a layer, as getTDMWindow() passes it to getTDMFetchMargin() */
+struct Source {
+    uint32_t srcLines;
+    uint32_t dstLines;
+    bool rot90;
+    bool afbc;
+    bool sbwc;
+
+    uint32_t getMargin() const { return getTDMFetchMargin(srcLines, dstLines, rot90, afbc, sbwc); }
+};
+
+/* Full screen plain, SBWC, AFBC, rotated, downscaled and upscaled sources */
+constexpr Source kSources[] = {
+        {2400, 2400, false, false, false}, {2400, 2400, false, false, true},
+        {2400, 2400, false, true, false},  {1080, 1080, true, false, false},
+        {4320, 1080, false, false, false}, {1080, 2160, false, false, false},
+        {540, 2160, true, true, false},    {1, 4096, false, true, true},
+};
+
+bool isOverlapped(int32_t y, int32_t h, uint32_t margin, int32_t compareY, int32_t compareH,
+                  uint32_t compareMargin) {
+    int32_t top, bottom, compareTop, compareBottom;
+    getTDMWindowLines(y, h, margin, 0, kYres, top, bottom);
+    getTDMWindowLines(compareY, compareH, compareMargin, 0, kYres, compareTop, compareBottom);
+    return isTDMWindowOverlapped(top, bottom, compareTop, compareBottom);
+}
+
+/* The fixed model: the checked source padded in both directions, the other one not */
+bool isOverlappedFixed(int32_t y, int32_t h, int32_t compareY, int32_t compareH) {
+    int32_t top, bottom, compareTop, compareBottom;
+    getTDMWindowLines(y, h, TDM_OVERLAP_MARGIN, TDM_OVERLAP_MARGIN, kYres, top, bottom);
+    getTDMWindowLines(compareY, compareH, 0, 0, kYres, compareTop, compareBottom);
+    return isTDMWindowOverlapped(top, bottom, compareTop, compareBottom);
+}
+
+} // namespace
+
+TEST(TDMWindowTest, FetchMarginOfSources) {
+    EXPECT_EQ(TDM_PIPELINE_LINES, getTDMFetchMargin(2400, 2400, false, false, false));
+    EXPECT_EQ(TDM_PIPELINE_LINES + TDM_SBWC_BLOCK_LINES,
+              getTDMFetchMargin(2400, 2400, false, false, true));
+    EXPECT_EQ(TDM_PIPELINE_LINES + TDM_AFBC_BLOCK_LINES,
+              getTDMFetchMargin(2400, 2400, false, true, false));
+    /* The rotation buffer and the pipeline are more than the fixed margin */
+    EXPECT_EQ(TDM_OVERLAP_MARGIN, getTDMFetchMargin(1080, 1080, true, false, false));
+    EXPECT_EQ(TDM_OVERLAP_MARGIN, getTDMFetchMargin(540, 2160, true, true, false));
+    /* Scaler taps in source lines, a quarter of a line rounds up to one */
+    EXPECT_EQ(TDM_PIPELINE_LINES + 1, getTDMFetchMargin(4320, 1080, false, false, false));
+    EXPECT_EQ(TDM_PIPELINE_LINES + 8, getTDMFetchMargin(1080, 2160, false, false, false));
+    EXPECT_EQ(TDM_OVERLAP_MARGIN, getTDMFetchMargin(1, 4096, false, true, true));
+    /* Nothing known of the source */
+    EXPECT_EQ(TDM_OVERLAP_MARGIN, getTDMFetchMargin(0, 2400, false, false, false));
+}
+
+TEST(TDMWindowTest, FetchMarginNeverExceedsFixedMargin) {
+    for (uint32_t srcLines = 1; srcLines <= 4096; srcLines += 13) {
+        for (uint32_t dstLines : {1u, 100u, 1080u, 2400u, 4096u}) {
+            for (uint32_t flags = 0; flags < 8; flags++) {
+                const uint32_t margin = getTDMFetchMargin(srcLines, dstLines, flags & 1,
+                                                          flags & 2, flags & 4);
+                EXPECT_GE(margin, TDM_PIPELINE_LINES);
+                EXPECT_LE(margin, TDM_OVERLAP_MARGIN);
+            }
+        }
+    }
+}
+
+TEST(TDMWindowTest, PadsTopOnly) {
+    int32_t top, bottom;
+    getTDMWindowLines(100, 200, 20, 0, kYres, top, bottom);
+    EXPECT_EQ(80, top);
+    EXPECT_EQ(300, bottom);
+}
+
+TEST(TDMWindowTest, ClipsToDisplay) {
+    int32_t top, bottom;
+    getTDMWindowLines(10, kYres, TDM_OVERLAP_MARGIN, TDM_OVERLAP_MARGIN, kYres, top, bottom);
+    EXPECT_EQ(0, top);
+    EXPECT_EQ(kYres, bottom);
+}
+
+TEST(TDMWindowTest, CatchesFetchAheadOfLowerSource) {
+    /* An AFBC source 10 lines below another is fetched while the other is scanned out */
+    const uint32_t afbc = getTDMFetchMargin(1200, 1200, false, true, false);
+    const uint32_t plain = getTDMFetchMargin(1000, 1000, false, false, false);
+    EXPECT_TRUE(isOverlapped(0, 1000, plain, 1010, 1200, afbc));
+    EXPECT_TRUE(isOverlapped(1010, 1200, afbc, 0, 1000, plain));
+    /* A rotated source is read the whole fixed margin ahead */
+    const uint32_t rotated = getTDMFetchMargin(1080, 1080, true, false, false);
+    EXPECT_TRUE(isOverlapped(0, 1000, plain, 1000 + TDM_OVERLAP_MARGIN, 1080, rotated));
+    EXPECT_TRUE(isOverlappedFixed(0, 1000, 1000 + TDM_OVERLAP_MARGIN, 1080));
+    /* Beyond the fetch of the lower one, a plain source is not read before it is needed */
+    EXPECT_FALSE(isOverlapped(0, 1000, afbc, 1000 + plain + 1, 1000, plain));
+}
+
+TEST(TDMWindowTest, LowerSourceLeadDecides) {
+    /* The upper source is scanned out at [0, 100], the lower one starts gap lines below */
+    for (const auto &upper : kSources) {
+        for (const auto &lower : kSources) {
+            const int32_t lowerMargin = static_cast<int32_t>(lower.getMargin());
+            for (int32_t gap = 0; gap <= 2 * static_cast<int32_t>(TDM_OVERLAP_MARGIN); gap++) {
+                EXPECT_EQ(gap <= lowerMargin,
+                          isOverlapped(0, 100, upper.getMargin(), 100 + gap, 100,
+                                       lower.getMargin()))
+                        << "upper margin " << upper.getMargin() << " lower margin "
+                        << lowerMargin << " gap " << gap;
+            }
+        }
+    }
+}
+
+TEST(TDMWindowTest, Symmetric) {
+    for (const auto &source : kSources) {
+        for (const auto &compare : kSources) {
+            for (int32_t y = 0; y < 600; y += 7) {
+                EXPECT_EQ(isOverlapped(300, 100, source.getMargin(), y, 50, compare.getMargin()),
+                          isOverlapped(y, 50, compare.getMargin(), 300, 100, source.getMargin()));
+            }
+        }
+    }
+}
+
+TEST(TDMWindowTest, NeverApartFurtherThanFixedMargin) {
+    /* Sources overlapping in the fetch model overlapped in the fixed one too */
+    for (const auto &source : kSources) {
+        for (const auto &compare : kSources) {
+            for (int32_t y = 0; y < 600; y++) {
+                if (!isOverlapped(300, 100, source.getMargin(), y, 50, compare.getMargin()))
+                    continue;
+                EXPECT_TRUE(isOverlappedFixed(300, 100, y, 50)) << "y " << y;
+                EXPECT_TRUE(isOverlappedFixed(y, 50, 300, 100)) << "y " << y;
+            }
+        }
+    }
+}